@@ -0,0 +1,100 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_BENCHMARKS_ALIGNED_ARENA_H
+#define CONDUIT_BENCHMARKS_ALIGNED_ARENA_H
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace sst::conduit::benchmarks
+{
+/*
+ * A runtime sized array of T living in a single cache line aligned allocation, with the
+ * same interface as shared::HugePageArena. The plugins all use the huge page arena now;
+ * this is the ordinary 4k page baseline the huge pages benchmark compares it against.
+ */
+template <typename T> struct AlignedArena
+{
+    static constexpr size_t alignment{alignof(T) > 64 ? alignof(T) : 64};
+
+    AlignedArena() = default;
+    AlignedArena(const AlignedArena &) = delete;
+    AlignedArena &operator=(const AlignedArena &) = delete;
+    ~AlignedArena() { reset(); }
+
+    template <typename... Args> void allocate(size_t n, Args &&...args)
+    {
+        reset();
+        if (n == 0)
+            return;
+
+        auto mem = ::operator new(n * sizeof(T), std::align_val_t(alignment));
+        data = static_cast<T *>(mem);
+        for (size_t i = 0; i < n; ++i)
+        {
+            new (data + i) T(args...);
+        }
+        count = n;
+    }
+
+    void reset()
+    {
+        if (!data)
+            return;
+
+        for (size_t i = count; i > 0; --i)
+        {
+            data[i - 1].~T();
+        }
+        ::operator delete(data, std::align_val_t(alignment));
+        data = nullptr;
+        count = 0;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    T &operator[](size_t i)
+    {
+        assert(i < count);
+        return data[i];
+    }
+    const T &operator[](size_t i) const
+    {
+        assert(i < count);
+        return data[i];
+    }
+
+    T *begin() { return data; }
+    T *end() { return data + count; }
+    const T *begin() const { return data; }
+    const T *end() const { return data + count; }
+
+  private:
+    T *data{nullptr};
+    size_t count{0};
+};
+} // namespace sst::conduit::benchmarks
+
+#endif // CONDUIT_BENCHMARKS_ALIGNED_ARENA_H
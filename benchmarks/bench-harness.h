@@ -0,0 +1,187 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_BENCHMARKS_BENCH_HARNESS_H
+#define CONDUIT_BENCHMARKS_BENCH_HARNESS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "perf-counters.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define CONDUIT_BENCH_HAS_TSC 1
+#endif
+
+namespace sst::conduit::benchmarks
+{
+/*
+ * Just enough harness for the conduit benchmarks: run a body a number of times after a
+ * warm up, report the median and best time per iteration. These are built only with
+ * CONDUIT_BUILD_BENCHMARKS and are meant to be run by hand on a quiet (or deliberately
+ * busy) machine, not as a gate.
+ *
+ * Cycles come from the time stamp counter where there is one. That ticks at a fixed
+ * reference rate rather than the core clock, so pin the frequency if you want samples
+ * per cycle to mean core cycles. Run with CONDUIT_BENCH_PERF=1 on Linux to also get the
+ * hardware counters in perf-counters.h, averaged per iteration over the timed runs.
+ */
+struct Result
+{
+    std::string name;
+    double medianNs{0}, bestNs{0};
+    double medianCycles{0}; // zero if we have no cycle counter
+    uint64_t iterations{0};
+
+    bool hasCounters{false};
+    PerfCounters::values_t counters{}; // per iteration, -1 where unavailable
+};
+
+inline uint64_t cycleCount()
+{
+#if CONDUIT_BENCH_HAS_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// Walk a buffer well beyond the last level cache so the next run starts cold
+inline void evictCaches()
+{
+    static std::vector<char> junk(64 * 1024 * 1024, 1);
+    for (size_t i = 0; i < junk.size(); i += 64)
+        junk[i]++;
+}
+
+// Keeps the compiler from discarding a computed value
+template <typename T> inline void doNotOptimize(const T &v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(v) : "memory");
+#else
+    static volatile T sink;
+    sink = v;
+#endif
+}
+
+namespace detail
+{
+template <typename F>
+Result measure(const std::string &name, uint64_t iterations, F &&body, int repeats, bool cold)
+{
+    using clock_t = std::chrono::steady_clock;
+
+    auto &perf = PerfCounters::get();
+    PerfCounters::values_t totals{};
+
+    std::vector<double> per, cyc;
+    for (int r = 0; r < repeats; ++r)
+    {
+        if (cold)
+            evictCaches();
+
+        if (perf.enabled())
+            perf.start();
+        auto s = clock_t::now();
+        auto c0 = cycleCount();
+        body(iterations);
+        auto c1 = cycleCount();
+        auto e = clock_t::now();
+        if (perf.enabled())
+        {
+            auto v = perf.stop();
+            for (int i = 0; i < PerfCounters::nCounters; ++i)
+                totals[i] = (v[i] < 0 || totals[i] < 0) ? -1 : totals[i] + v[i];
+        }
+        per.push_back(std::chrono::duration<double, std::nano>(e - s).count() / iterations);
+        cyc.push_back(1.0 * (c1 - c0) / iterations);
+    }
+    std::sort(per.begin(), per.end());
+    std::sort(cyc.begin(), cyc.end());
+
+    Result res;
+    res.name = name;
+    res.medianNs = per[per.size() / 2];
+    res.bestNs = per.front();
+    res.medianCycles = cyc[cyc.size() / 2];
+    res.iterations = iterations;
+    res.hasCounters = perf.enabled();
+    for (int i = 0; i < PerfCounters::nCounters; ++i)
+        res.counters[i] = totals[i] < 0 ? -1 : totals[i] / (1.0 * iterations * repeats);
+    return res;
+}
+} // namespace detail
+
+template <typename F>
+Result run(const std::string &name, uint64_t iterations, F &&body, int repeats = 9)
+{
+    body(iterations / 10 + 1); // warm up caches, TLB and branch predictors
+    return detail::measure(name, iterations, body, repeats, false);
+}
+
+/*
+ * The cold variant evicts the caches before every timed call. Give it a short call (a
+ * block, say) so the first touch of state, tables and code dominates.
+ */
+template <typename F>
+Result runCold(const std::string &name, uint64_t iterations, F &&body, int repeats = 31)
+{
+    body(iterations);
+    return detail::measure(name, iterations, body, repeats, true);
+}
+
+inline void report(const Result &r)
+{
+    if (r.medianCycles > 0)
+        printf("%-44s %9.3f ns/iter (best %9.3f)  %8.4f iter/cycle\n", r.name.c_str(),
+               r.medianNs, r.bestNs, 1.0 / r.medianCycles);
+    else
+        printf("%-44s %9.3f ns/iter (best %9.3f)\n", r.name.c_str(), r.medianNs, r.bestNs);
+
+    if (!r.hasCounters)
+        return;
+
+    const auto &c = r.counters;
+    printf("    ");
+    if (c[PerfCounters::CYCLES] > 0 && c[PerfCounters::INSTRUCTIONS] >= 0)
+        printf("IPC %5.2f  ", c[PerfCounters::INSTRUCTIONS] / c[PerfCounters::CYCLES]);
+    for (int i = 0; i < PerfCounters::nCounters; ++i)
+    {
+        if (c[i] >= 0)
+            printf("%s %.4g  ", PerfCounters::names[i], c[i]);
+        else
+            printf("%s n/a  ", PerfCounters::names[i]);
+    }
+    printf("(per iter)\n");
+}
+} // namespace sst::conduit::benchmarks
+
+#endif // CONDUIT_BENCHMARKS_BENCH_HARNESS_H
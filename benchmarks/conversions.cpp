@@ -0,0 +1,104 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+/*
+ * The table conversions the plugins use in place of pow: accuracy against pow over the
+ * ranges the plugins feed them, and speed. Exits non zero if a table is outside its
+ * bound, so it doubles as a check when the tables or their library change.
+ *
+ *   2^x, envelope rates and pitch offsets in octaves, x in [-12, 12]: 1e-4 relative
+ *   note to frequency, notes in [-60, 160]: 1e-3 relative, about 1.7 cents
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "bench-harness.h"
+
+#include "sst/basic-blocks/tables/EqualTuningProvider.h"
+#include "sst/basic-blocks/tables/TwoToTheXProvider.h"
+
+namespace cb = sst::conduit::benchmarks;
+
+static constexpr double midiNoteZeroHz{8.17579891564}; // as in ClapBaseClass
+
+template <typename F, typename R>
+bool checkAccuracy(const char *name, double lo, double hi, double bound, F &&table, R &&reference)
+{
+    static constexpr int nPoints{200000};
+    double worst{0}, worstAt{lo};
+    for (int i = 0; i <= nPoints; ++i)
+    {
+        auto x = lo + (hi - lo) * i / nPoints;
+        auto ref = reference(x);
+        auto err = std::fabs(table((float)x) - ref) / std::fabs(ref);
+        if (err > worst)
+        {
+            worst = err;
+            worstAt = x;
+        }
+    }
+    auto ok = worst <= bound;
+    printf("%-44s max rel error %.3g at %.4f (bound %.0e) %s\n", name, worst, worstAt, bound,
+           ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main()
+{
+    sst::basic_blocks::tables::TwoToTheXProvider twoToX;
+    sst::basic_blocks::tables::EqualTuningProvider tuning;
+    twoToX.init();
+    tuning.init();
+
+    bool ok{true};
+    ok &= checkAccuracy(
+        "twoToThe", -12, 12, 1e-4, [&](float x) { return twoToX.twoToThe(x); },
+        [](double x) { return std::pow(2.0, x); });
+    ok &= checkAccuracy(
+        "note to frequency", -60, 160, 1e-3,
+        [&](float n) { return midiNoteZeroHz * tuning.note_to_pitch(n); },
+        [](double n) { return 440.0 * std::pow(2.0, (n - 69) / 12); });
+
+    static constexpr int n{4096};
+    std::vector<float> xs(n);
+    for (int i = 0; i < n; ++i)
+        xs[i] = -8.f + 16.f * i / n;
+
+    auto perValue = [&](auto &&f) {
+        return [&, f](uint64_t iters) {
+            for (uint64_t i = 0; i < iters; ++i)
+                cb::doNotOptimize(f(xs[i & (n - 1)]));
+        };
+    };
+    cb::report(cb::run("twoToThe (table)", 1 << 22,
+                       perValue([&](float x) { return twoToX.twoToThe(x); })));
+    cb::report(cb::run("2^x (std::pow)", 1 << 22,
+                       perValue([](float x) { return std::pow(2.f, x); })));
+    cb::report(cb::run("note to frequency (table)", 1 << 22,
+                       perValue([&](float x) { return tuning.note_to_pitch(x * 12 + 60); })));
+    cb::report(cb::run("note to frequency (std::pow)", 1 << 22, perValue([](float x) {
+                           return 440.f * std::pow(2.f, (x * 12 - 9) / 12);
+                       })));
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+/*
+ * The polymetric delay's own tap loop, on its own delay line type, with the lines in an
+ * ordinary aligned allocation and in a HugePageArena. Each channel has one write head and
+ * four sinc interpolated taps whose lengths are modulated by quadrature oscillators, as
+ * the delay runs them, over a few hundred thousand samples, so nearly every read lands
+ * on a different 4k page.
+ *
+ * The answer is in the dTLB misses and cycles per sample, so run it with
+ * CONDUIT_BENCH_PERF=1 on Linux, and to see the effect of a loaded machine, alongside
+ * something which churns the TLB.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <memory>
+
+#include "aligned-arena.h"
+#include "bench-harness.h"
+
+#include "sst/basic-blocks/dsp/QuadratureOscillators.h"
+#include "sst/basic-blocks/dsp/SSESincDelayLine.h"
+#include "sst/basic-blocks/tables/SincTableProvider.h"
+
+#include "conduit-shared/huge-page-arena.h"
+
+namespace cb = sst::conduit::benchmarks;
+namespace cs = sst::conduit::shared;
+
+// As ConduitPolymetricDelay declares them
+using line_t = sst::basic_blocks::dsp::SSESincDelayLine<1 << 20>;
+static constexpr int nTaps{4};
+static constexpr float modDepthScale{0.05f};
+static constexpr double sampleRate{48000};
+
+struct Taps
+{
+    // 120 bpm: 3 in 4, 5 in 4, 7 in 8 and 9 in 8 beats
+    float base[nTaps]{sampleRate * 0.5f * 4 / 3, sampleRate * 0.5f * 4 / 5,
+                      sampleRate * 0.5f * 8 / 7, sampleRate * 0.5f * 8 / 9};
+    float depth[nTaps]{1.f, 0.6f, 0.8f, 0.4f};
+    sst::basic_blocks::dsp::QuadratureOscillator<float> modulator[nTaps];
+
+    Taps()
+    {
+        for (int t = 0; t < nTaps; ++t)
+            modulator[t].setRate(2.0 * M_PI * (0.3 + 0.17 * t) / sampleRate);
+    }
+};
+
+template <typename Arena> float delayLoop(Arena &lines, Taps &taps, uint64_t samples)
+{
+    float acc{0};
+    for (uint64_t s = 0; s < samples; ++s)
+    {
+        float out[2]{0, 0}, fb[2]{0, 0};
+        for (int t = 0; t < nTaps; ++t)
+        {
+            auto &m = taps.modulator[t];
+            m.step();
+            auto tt = taps.base[t] * (1 + modDepthScale * taps.depth[t] * m.u);
+            auto l = lines[0].read(tt);
+            auto r = lines[1].read(tt);
+            out[0] += l;
+            out[1] += r;
+            fb[0] += 0.2f * l;
+            fb[1] += 0.2f * r;
+        }
+        lines[0].write(0.01f * std::sin(s * 0.01f) + fb[0]);
+        lines[1].write(0.01f * std::cos(s * 0.01f) + fb[1]);
+        acc += out[0] + out[1];
+    }
+    return acc;
+}
+
+int main()
+{
+    static constexpr uint64_t samples{1 << 18};
+
+    auto st = std::make_unique<sst::basic_blocks::tables::SurgeSincTableProvider>();
+    cb::AlignedArena<line_t> small;
+    small.allocate(2, *st);
+    cs::HugePageArena<line_t> huge;
+    huge.allocate(2, *st);
+
+    printf("HugePageArena %s huge page backed\n", huge.isHugePageBacked() ? "is" : "is NOT");
+
+    // Fill both so the reads see history rather than zeros
+    Taps fillTaps;
+    delayLoop(small, fillTaps, 1 << 20);
+    delayLoop(huge, fillTaps, 1 << 20);
+
+    Taps smallTaps, hugeTaps;
+    auto a = cb::run("delay taps, aligned new", samples,
+                     [&](uint64_t n) { cb::doNotOptimize(delayLoop(small, smallTaps, n)); });
+    auto h = cb::run("delay taps, huge page arena", samples,
+                     [&](uint64_t n) { cb::doNotOptimize(delayLoop(huge, hugeTaps, n)); });
+    cb::report(a);
+    cb::report(h);
+
+    // Per sample, the difference the huge pages make
+    if (a.medianCycles > 0)
+        printf("huge pages: %+.1f%% cycles per sample (%.1f vs %.1f)\n",
+               100.0 * (h.medianCycles / a.medianCycles - 1), h.medianCycles, a.medianCycles);
+
+    auto ta = a.counters[cb::PerfCounters::DTLB_MISSES];
+    auto th = h.counters[cb::PerfCounters::DTLB_MISSES];
+    if (a.hasCounters && ta >= 0 && th >= 0)
+        printf("huge pages: %.4g dTLB misses per sample (vs %.4g)\n", th, ta);
+    else
+        printf("run with CONDUIT_BENCH_PERF=1 for the dTLB misses\n");
+    return 0;
+}
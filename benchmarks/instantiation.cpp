@@ -0,0 +1,161 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+/*
+ * What a host sees on first play: create a plugin, init and activate it, then time the
+ * first process calls against the steady state, with the activate time warm up on and
+ * off. Each trial is a fresh instance, so the first block really is cold. The synth gets
+ * a note on in the first block so the voice pool is in play.
+ *
+ * The plugins talk to a host which offers no extensions and ignores every request.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include <clap/clap.h>
+
+#include "polymetric-delay/polymetric-delay.h"
+#include "polysynth/polysynth.h"
+#include "ring-modulator/ring-modulator.h"
+
+#include "silent-process.h"
+
+namespace cb = sst::conduit::benchmarks;
+
+using steady_t = std::chrono::steady_clock;
+
+static constexpr double sampleRate{48000};
+static constexpr uint32_t frames{256};
+static constexpr int trials{7}, steadyBlocks{200};
+
+// One note on at the start of the first block, nothing after
+struct FirstBlockNote
+{
+    clap_event_note note{};
+    bool sent{false};
+    clap_input_events events{};
+
+    FirstBlockNote()
+    {
+        note.header = {sizeof(clap_event_note), 0, CLAP_CORE_EVENT_SPACE_ID, CLAP_EVENT_NOTE_ON,
+                       0};
+        note.note_id = -1;
+        note.port_index = 0;
+        note.channel = 0;
+        note.key = 60;
+        note.velocity = 0.8;
+
+        events.ctx = this;
+        events.size = [](const clap_input_events *e) -> uint32_t {
+            return static_cast<const FirstBlockNote *>(e->ctx)->sent ? 0 : 1;
+        };
+        events.get = [](const clap_input_events *e, uint32_t) -> const clap_event_header_t * {
+            return &static_cast<const FirstBlockNote *>(e->ctx)->note.header;
+        };
+    }
+};
+
+struct Trial
+{
+    double activateUs{0}, firstUs{0}, secondUs{0}, steadyUs{0};
+};
+
+template <typename P> Trial runTrial(bool warmUp, bool withNote)
+{
+    auto *plugin = new P(&cb::nullHost);
+    plugin->warmUpOnActivate = warmUp;
+    auto *cp = plugin->clapPlugin();
+    cp->init(cp);
+
+    Trial res;
+    auto us = [](auto a, auto b) {
+        return std::chrono::duration<double, std::micro>(b - a).count();
+    };
+
+    auto t0 = steady_t::now();
+    cp->activate(cp, sampleRate, 1, frames);
+    auto t1 = steady_t::now();
+    res.activateUs = us(t0, t1);
+
+    cp->start_processing(cp);
+    cb::SilentProcess proc(cb::portChannels(cp, true), cb::portChannels(cp, false), frames);
+    FirstBlockNote note;
+    if (withNote)
+        proc.process.in_events = &note.events;
+
+    std::vector<double> steady;
+    for (int b = 0; b < steadyBlocks + 2; ++b)
+    {
+        auto s = steady_t::now();
+        cp->process(cp, &proc.process);
+        auto e = steady_t::now();
+        note.sent = true;
+
+        if (b == 0)
+            res.firstUs = us(s, e);
+        else if (b == 1)
+            res.secondUs = us(s, e);
+        else
+            steady.push_back(us(s, e));
+    }
+    std::sort(steady.begin(), steady.end());
+    res.steadyUs = steady[steady.size() / 2];
+
+    cp->stop_processing(cp);
+    cp->deactivate(cp);
+    cp->destroy(cp);
+    return res;
+}
+
+template <typename P> void measure(const char *name, bool withNote)
+{
+    for (auto warm : {false, true})
+    {
+        std::vector<Trial> ts;
+        for (int t = 0; t < trials; ++t)
+            ts.push_back(runTrial<P>(warm, withNote));
+
+        auto median = [&ts](double Trial::*m) {
+            std::vector<double> v;
+            for (auto &t : ts)
+                v.push_back(t.*m);
+            std::sort(v.begin(), v.end());
+            return v[v.size() / 2];
+        };
+        printf("%-16s warm up %-3s  activate %9.1f us  first block %8.1f us  second %8.1f us"
+               "  steady %8.1f us\n",
+               name, warm ? "on" : "off", median(&Trial::activateUs), median(&Trial::firstUs),
+               median(&Trial::secondUs), median(&Trial::steadyUs));
+    }
+}
+
+int main()
+{
+    printf("%u frame blocks at %.0f Hz, median of %d fresh instances\n", frames, sampleRate,
+           trials);
+    measure<sst::conduit::polymetric_delay::ConduitPolymetricDelay>("polymetric delay", false);
+    measure<sst::conduit::ring_modulator::ConduitRingModulator>("ring modulator", false);
+    measure<sst::conduit::polysynth::ConduitPolysynth>("polysynth", true);
+    return 0;
+}
@@ -0,0 +1,469 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+/*
+ * Per kernel numbers for the DSP building blocks the plugins spend their time in. Each
+ * kernel runs on 16 sample (one oversampled voice block) chunks and is reported warm,
+ * over many blocks, and cold, one block after evicting the caches, as ns per sample and
+ * samples per cycle.
+ *
+ * Everything is driven the way the plugins drive it (the same filter types, waveshaper
+ * registers, oversampling), so a change in these numbers should show up in the plugin.
+ * Kernels which stand in for a library one (the waveshaper tables, the modulator bank)
+ * also report their max deviation from it.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+
+#include "bench-harness.h"
+
+#include "sst/basic-blocks/dsp/CorrelatedNoise.h"
+#include "sst/basic-blocks/dsp/DPWSawPulseOscillator.h"
+#include "sst/basic-blocks/dsp/QuadratureOscillators.h"
+#include "sst/basic-blocks/dsp/SSESincDelayLine.h"
+#include "sst/basic-blocks/modulators/ADSREnvelope.h"
+#include "sst/basic-blocks/modulators/SimpleLFO.h"
+#include "sst/basic-blocks/tables/SincTableProvider.h"
+#include "sst/filters.h"
+#include "sst/filters/HalfRateFilter.h"
+#include "sst/waveshapers.h"
+
+#include "conduit-shared/huge-page-arena.h"
+#include "polysynth/modulator-bank.h"
+#include "polysynth/voice.h"
+#include "polysynth/saw-wavetable.h"
+#include "polysynth/waveshaper-tables.h"
+#include "ring-modulator/ring-modulator.h"
+
+namespace cb = sst::conduit::benchmarks;
+namespace cp = sst::conduit::polysynth;
+
+static constexpr int block{cp::PolysynthVoice::blockSizeOS};
+static constexpr uint64_t warmSamples{block * 16384};
+static constexpr double sampleRate{48000 * 2};
+static constexpr double srInv{1.0 / sampleRate};
+
+// Runs body(nBlocks) warm and then cold on a single block, and reports both
+template <typename F> void kernel(const std::string &name, F &&perBlock)
+{
+    auto body = [&](uint64_t samples) {
+        for (uint64_t s = 0; s < samples; s += block)
+            perBlock();
+    };
+    cb::report(cb::run(name, warmSamples, body));
+    cb::report(cb::runCold(name + " [cold]", block, body));
+}
+
+struct Frames
+{
+    __m128 data[block];
+    Frames()
+    {
+        std::minstd_rand gen(2112);
+        std::uniform_real_distribution<float> d(-1.f, 1.f);
+        for (auto &f : data)
+            f = _mm_set_ps(0, 0, d(gen), d(gen));
+    }
+};
+
+template <int Mode> void svf(const std::string &name, Frames &in)
+{
+    cp::PolysynthVoice::StereoSimperSVF f;
+    f.init();
+    f.setCoeff(523.25, 0.6, srInv); // key 72
+    kernel("svf " + name, [&]() {
+        for (auto &s : in.data)
+            cb::doNotOptimize(cp::PolysynthVoice::StereoSimperSVF::stepSSE<Mode>(f, s));
+    });
+}
+
+void quadFilter(int lpfType, const std::string &name, Frames &in)
+{
+    static float delayBuffers[4][sst::filters::utilities::MAX_FB_COMB +
+                                 sst::filters::utilities::SincTable::FIRipol_N]{};
+
+    sst::filters::QuadFilterUnitState qfs{};
+    for (int i = 0; i < 4; ++i)
+    {
+        memset(delayBuffers[i], 0, sizeof(delayBuffers[i]));
+        qfs.DB[i] = delayBuffers[i];
+        qfs.active[i] = (int)0xffffffff;
+        qfs.WP[i] = 0;
+    }
+
+    auto [type, subType] = cp::PolysynthVoice::lpfFilterTypes(lpfType);
+    sst::filters::FilterCoefficientMaker coefMaker;
+    coefMaker.setSampleRateAndBlockSize(sampleRate, cp::PolysynthVoice::blockSize);
+    coefMaker.MakeCoeffs(12, 0.5, type, subType, nullptr, false);
+    coefMaker.updateState(qfs);
+
+    auto fp = sst::filters::GetCompensatedQFPtrFilterUnit<true>(type, subType);
+    kernel("lpf " + name, [&]() {
+        for (auto &s : in.data)
+            cb::doNotOptimize(fp(&qfs, s));
+    });
+}
+
+void waveshaper(int shape, const std::string &name, Frames &in)
+{
+    auto type = cp::WaveshaperTables::typeFor(shape);
+    sst::waveshapers::QuadWaveshaperState st;
+    const auto drive = _mm_set1_ps(2.f);
+
+    auto exact = sst::waveshapers::GetQuadWaveshaper(type);
+    cp::WaveshaperTables::initializeState(type, st);
+    kernel("waveshaper " + name, [&]() {
+        for (auto &s : in.data)
+            cb::doNotOptimize(exact(&st, s, drive));
+    });
+
+    // The tables measure themselves against the exact kernels when they are built
+    const auto &tb = cp::WaveshaperTables::get().tables[shape];
+    printf("%-44s table max error %.3g%s\n", ("waveshaper " + name).c_str(), tb.measuredError,
+           tb.usable ? "" : " (table disabled)");
+
+    auto table = cp::WaveshaperTables::get().lookupFor(shape);
+    if (table)
+    {
+        cp::WaveshaperTables::initializeState(type, st);
+        kernel("waveshaper " + name + " (table)", [&]() {
+            for (auto &s : in.data)
+                cb::doNotOptimize(table(&st, s, drive));
+        });
+    }
+}
+
+/*
+ * The sample rate interface the sst modulators ask their owner for, as the voice answers
+ * it, so the library envelope and LFO can run here as the reference for the modulator bank
+ */
+struct ModulatorClock
+{
+    ModulatorClock() { twoToX.init(); }
+    sst::basic_blocks::tables::TwoToTheXProvider twoToX;
+    float samplerate{(float)sampleRate};
+    float envelope_rate_linear_nowrap(float f) { return block * srInv * twoToX.twoToThe(-f); }
+};
+
+void envelopes()
+{
+    using bank_t = cp::ModulatorBank;
+    using env_t = sst::basic_blocks::modulators::ADSREnvelope<ModulatorClock, block>;
+    static_assert(bank_t::lanes == 4 && bank_t::blockSize == block);
+
+    ModulatorClock clock;
+    const auto &twoToX = clock.twoToX;
+    auto rateOffset = bank_t::envelopeRateOffset(sampleRate);
+
+    // attack, decay, sustain, release; one setting per lane
+    static constexpr float settings[][bank_t::lanes][4]{
+        {{0.f, 0.f, 1.f, 0.f}, {0.1f, 0.3f, 0.5f, 0.2f}, {0.3f, 0.4f, 0.5f, 0.4f},
+         {0.6f, 0.6f, 0.f, 0.7f}},
+        {{0.2f, 0.1f, 0.8f, 0.1f}, {0.5f, 0.2f, 0.2f, 0.5f}, {0.8f, 0.8f, 0.9f, 0.3f},
+         {1.f, 1.f, 0.3f, 1.f}},
+    };
+
+    float maxDev{0};
+    for (const auto &set : settings)
+    {
+        std::array<env_t, bank_t::lanes> ref{env_t(&clock), env_t(&clock), env_t(&clock),
+                                             env_t(&clock)};
+        bank_t::EnvLanes e;
+        for (int l = 0; l < bank_t::lanes; ++l)
+        {
+            ref[l].attackFrom(0.f, set[l][0], 0, false);
+            auto s = set[l][2];
+            e.sustain[l] = s * s;
+            e.coefA[l] = bank_t::envelopeCoefficient(twoToX, rateOffset, set[l][0]);
+            e.coefD[l] = bank_t::envelopeCoefficient(twoToX, rateOffset, set[l][1]);
+            e.coefR[l] = bank_t::envelopeCoefficient(twoToX, rateOffset, set[l][3]);
+        }
+
+        // Gate for a second and then release for two
+        auto gateBlocks = (int)(sampleRate / block);
+        for (int b = 0; b < 3 * gateBlocks; ++b)
+        {
+            auto gated = b < gateBlocks;
+            for (int l = 0; l < bank_t::lanes; ++l)
+            {
+                ref[l].processBlock(set[l][0], set[l][1], set[l][2], set[l][3], 0, 0, 0, gated);
+                e.gate[l] = gated ? bank_t::gateVolts : 0.f;
+            }
+            bank_t::stepEnvelopes(e);
+            for (int l = 0; l < bank_t::lanes; ++l)
+                for (int s = 0; s < block; ++s)
+                    maxDev = std::max(maxDev, std::fabs(ref[l].outputCache[s] - e.cache[s][l]));
+        }
+    }
+    printf("%-44s max deviation %.3g\n", "modulator bank ADSR", maxDev);
+
+    std::array<env_t, bank_t::lanes> ref{env_t(&clock), env_t(&clock), env_t(&clock),
+                                         env_t(&clock)};
+    for (auto &r : ref)
+        r.attackFrom(0.f, 0.3f, 0, false);
+    kernel("ADSR analog x4", [&]() {
+        for (auto &r : ref)
+        {
+            r.processBlock(0.3f, 0.4f, 0.5f, 0.4f, 0, 0, 0, true);
+            cb::doNotOptimize(r.outputCache[0]);
+        }
+    });
+
+    bank_t::EnvLanes e;
+    for (int l = 0; l < bank_t::lanes; ++l)
+    {
+        e.gate[l] = bank_t::gateVolts;
+        e.sustain[l] = 0.25f;
+        e.coefA[l] = bank_t::envelopeCoefficient(twoToX, rateOffset, 0.3f);
+        e.coefD[l] = e.coefR[l] = bank_t::envelopeCoefficient(twoToX, rateOffset, 0.4f);
+    }
+    kernel("modulator bank ADSR x4", [&]() {
+        bank_t::stepEnvelopes(e);
+        cb::doNotOptimize(e.cache[0][0]);
+    });
+}
+
+void lfos()
+{
+    using bank_t = cp::ModulatorBank;
+    using lfo_t = sst::basic_blocks::modulators::SimpleLFO<ModulatorClock, block>;
+
+    // The noise shapes stay on the library LFO in the bank, so only these are checked
+    static constexpr int shapes[bank_t::lanes]{lfo_t::SINE, lfo_t::RAMP, lfo_t::TRI,
+                                               lfo_t::PULSE};
+    static constexpr float rates[]{-3.f, 0.f, 2.5f, 5.f};
+    static constexpr float deforms[]{0.f, 0.4f, -0.7f, 1.f};
+
+    ModulatorClock clock;
+    float maxDev{0};
+    for (auto rate : rates)
+    {
+        for (auto deform : deforms)
+        {
+            std::array<lfo_t, bank_t::lanes> ref{lfo_t(&clock), lfo_t(&clock), lfo_t(&clock),
+                                                 lfo_t(&clock)};
+            bank_t::LfoLanes ll;
+            for (int l = 0; l < bank_t::lanes; ++l)
+            {
+                ref[l].attack(shapes[l]);
+                ll.phase[l] = ref[l].phase;
+                ll.last[l] = ref[l].lastTarget;
+                ll.shape[l] = shapes[l];
+                ll.deform[l] = deform;
+                ll.increment[l] = clock.envelope_rate_linear_nowrap(-rate);
+            }
+
+            for (int b = 0; b < (int)(2 * sampleRate / block); ++b)
+            {
+                for (int l = 0; l < bank_t::lanes; ++l)
+                    ref[l].process_block(rate, deform, shapes[l]);
+                bank_t::stepLFOs(ll);
+                for (int l = 0; l < bank_t::lanes; ++l)
+                    for (int s = 0; s < block; ++s)
+                        maxDev =
+                            std::max(maxDev, std::fabs(ref[l].outputBlock[s] - ll.block[s][l]));
+            }
+        }
+    }
+    printf("%-44s max deviation %.3g\n", "modulator bank LFO", maxDev);
+
+    std::array<lfo_t, bank_t::lanes> ref{lfo_t(&clock), lfo_t(&clock), lfo_t(&clock),
+                                         lfo_t(&clock)};
+    for (int l = 0; l < bank_t::lanes; ++l)
+        ref[l].attack(shapes[l]);
+    kernel("SimpleLFO x4", [&]() {
+        for (int l = 0; l < bank_t::lanes; ++l)
+        {
+            ref[l].process_block(1.f, 0.4f, shapes[l]);
+            cb::doNotOptimize(ref[l].outputBlock[0]);
+        }
+    });
+
+    bank_t::LfoLanes ll;
+    for (int l = 0; l < bank_t::lanes; ++l)
+    {
+        ll.shape[l] = shapes[l];
+        ll.deform[l] = 0.4f;
+        ll.increment[l] = clock.envelope_rate_linear_nowrap(-1.f);
+    }
+    kernel("modulator bank LFO x4", [&]() {
+        bank_t::stepLFOs(ll);
+        cb::doNotOptimize(ll.block[0][0]);
+    });
+}
+
+int main()
+{
+    Frames frames;
+
+    svf<cp::PolysynthVoice::StereoSimperSVF::LP>("LP", frames);
+    svf<cp::PolysynthVoice::StereoSimperSVF::HP>("HP", frames);
+    svf<cp::PolysynthVoice::StereoSimperSVF::BP>("BP", frames);
+    svf<cp::PolysynthVoice::StereoSimperSVF::NOTCH>("Notch", frames);
+    svf<cp::PolysynthVoice::StereoSimperSVF::PEAK>("Peak", frames);
+    svf<cp::PolysynthVoice::StereoSimperSVF::ALL>("Allpass", frames);
+
+    quadFilter(cp::PolysynthVoice::OBXD, "OBXD", frames);
+    quadFilter(cp::PolysynthVoice::Vintage, "Vintage", frames);
+    quadFilter(cp::PolysynthVoice::K35, "K35", frames);
+    quadFilter(cp::PolysynthVoice::CutWarp, "CutWarp", frames);
+    quadFilter(cp::PolysynthVoice::ResWarp, "ResWarp", frames);
+    quadFilter(cp::PolysynthVoice::Comb, "Comb", frames);
+
+    waveshaper(cp::PolysynthVoice::Soft, "Soft", frames);
+    waveshaper(cp::PolysynthVoice::OJD, "OJD", frames);
+    waveshaper(cp::PolysynthVoice::Digital, "Digital", frames);
+    waveshaper(cp::PolysynthVoice::FullWaveRect, "FullWaveRect", frames);
+    waveshaper(cp::PolysynthVoice::WestcoastFold, "WestcoastFold", frames);
+    waveshaper(cp::PolysynthVoice::Fuzz, "Fuzz", frames);
+
+    envelopes();
+    lfos();
+
+    {
+        using strat_t =
+            sst::basic_blocks::dsp::BlockInterpSmoothingStrategy<cp::PolysynthVoice::blockSize>;
+        sst::basic_blocks::dsp::DPWSawOscillator<strat_t> saw;
+        saw.setFrequency(220.0, srInv);
+        kernel("DPW saw", [&]() {
+            for (int s = 0; s < block; ++s)
+                cb::doNotOptimize(saw.step());
+        });
+
+        sst::basic_blocks::dsp::DPWPulseOscillator<strat_t> pulse;
+        pulse.setFrequency(220.0, srInv);
+        pulse.setPulseWidth(0.3);
+        kernel("DPW pulse", [&]() {
+            for (int s = 0; s < block; ++s)
+                cb::doNotOptimize(pulse.step());
+        });
+
+        sst::basic_blocks::dsp::QuadratureOscillator<float> quad;
+        quad.setRate(2.0 * M_PI * 220.0 * srInv);
+        kernel("quadrature sine", [&]() {
+            for (int s = 0; s < block; ++s)
+            {
+                quad.step();
+                cb::doNotOptimize(quad.u);
+            }
+        });
+    }
+
+    {
+        float panL[cp::WavetableSawUnison::maxUnison], panR[cp::WavetableSawUnison::maxUnison],
+            norm[cp::WavetableSawUnison::maxUnison];
+        for (int i = 0; i < cp::WavetableSawUnison::maxUnison; ++i)
+        {
+            panL[i] = panR[i] = 1.f;
+            norm[i] = 0.4f;
+        }
+        cp::WavetableSawUnison uni;
+        uni.setUnison(7, panL, panR, norm);
+        for (int i = 0; i < 7; ++i)
+            uni.setPhaseIncrement(i, (220.0 + i) * srInv);
+        uni.updateLevel();
+        __m128 out[block];
+        kernel("wavetable saw x7", [&]() {
+            uni.processBlock<block>(out);
+            cb::doNotOptimize(out[0]);
+        });
+
+        cp::WavetablePulse pulse;
+        pulse.setPhaseIncrement(220.0 * srInv);
+        pulse.setPulseWidth(0.3);
+        kernel("wavetable pulse", [&]() {
+            for (int s = 0; s < block; ++s)
+                cb::doNotOptimize(pulse.step());
+        });
+    }
+
+    {
+        sst::filters::HalfRate::HalfRateFilter down(6, true), up(6, true);
+        float inL alignas(16)[block], inR alignas(16)[block];
+        float outL alignas(16)[block], outR alignas(16)[block];
+        for (int s = 0; s < block; ++s)
+        {
+            inL[s] = std::sin(s * 0.1f);
+            inR[s] = std::cos(s * 0.1f);
+        }
+        kernel("halfrate D2", [&]() {
+            down.process_block_D2(inL, inR, block, outL, outR);
+            cb::doNotOptimize(outL[0]);
+        });
+        kernel("halfrate U2", [&]() {
+            up.process_block_U2(inL, inR, outL, outR, block);
+            cb::doNotOptimize(outL[0]);
+        });
+    }
+
+    {
+        using line_t = sst::basic_blocks::dsp::SSESincDelayLine<1 << 20>;
+        auto st = std::make_unique<sst::basic_blocks::tables::SurgeSincTableProvider>();
+        sst::conduit::shared::HugePageArena<line_t> line;
+        line.allocate(1, *st);
+        for (int i = 0; i < (1 << 20); ++i)
+            line[0].write(std::sin(i * 0.001f));
+
+        float phase{0};
+        kernel("sinc delay read", [&]() {
+            for (int s = 0; s < block; ++s)
+            {
+                phase += 0.001f;
+                cb::doNotOptimize(line[0].read(48000 * (1.5f + 0.01f * std::sin(phase))));
+            }
+        });
+    }
+
+    {
+        float v{-2.f};
+        kernel("ring mod diode_sim", [&]() {
+            for (int s = 0; s < block; ++s)
+            {
+                v += 0.001f;
+                if (v > 2)
+                    v = -2;
+                cb::doNotOptimize(sst::conduit::ring_modulator::diode_sim(v));
+            }
+        });
+    }
+
+    {
+        float w0{0}, w1{0};
+        std::minstd_rand gen(8675309);
+        std::uniform_real_distribution<float> urd(-1.f, 1.f);
+        float rnd[block];
+        for (auto &r : rnd)
+            r = urd(gen);
+        kernel("correlated noise o2mk2", [&]() {
+            for (int s = 0; s < block; ++s)
+                cb::doNotOptimize(sst::basic_blocks::dsp::correlated_noise_o2mk2_supplied_value(
+                    w0, w1, 0.3f, rnd[s]));
+        });
+    }
+
+    return 0;
+}
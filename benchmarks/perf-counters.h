@@ -0,0 +1,168 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_BENCHMARKS_PERF_COUNTERS_H
+#define CONDUIT_BENCHMARKS_PERF_COUNTERS_H
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define CONDUIT_BENCH_HAS_PERF 1
+#endif
+
+namespace sst::conduit::benchmarks
+{
+/*
+ * Hardware counters around a measured region, from perf_event_open on Linux. They are
+ * only opened if CONDUIT_BENCH_PERF is set in the environment, and each counter is
+ * opened on its own rather than as a group, so a machine (or VM, or perf_event_paranoid
+ * setting) which lacks one still reports the rest. Counters the kernel had to multiplex
+ * are scaled by enabled over running time.
+ *
+ * Compute bound kernels show high IPC and few misses; the delay lines and anything
+ * else memory bound show up in the LLC and dTLB columns.
+ */
+struct PerfCounters
+{
+    enum Counter
+    {
+        CYCLES,
+        INSTRUCTIONS,
+        L1D_MISSES,
+        LLC_MISSES,
+        BRANCH_MISSES,
+        DTLB_MISSES,
+
+        nCounters
+    };
+    static constexpr const char *names[nCounters]{"cycles", "instr",   "L1D miss",
+                                                  "LLC miss", "br miss", "dTLB miss"};
+
+    // A value of -1 means that counter could not be opened
+    using values_t = std::array<double, nCounters>;
+
+    static PerfCounters &get()
+    {
+        static PerfCounters instance;
+        return instance;
+    }
+
+    bool enabled() const { return anyOpen; }
+
+    void start()
+    {
+#if CONDUIT_BENCH_HAS_PERF
+        for (auto fd : fds)
+        {
+            if (fd < 0)
+                continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    values_t stop()
+    {
+        values_t res;
+        res.fill(-1);
+#if CONDUIT_BENCH_HAS_PERF
+        for (int i = 0; i < nCounters; ++i)
+        {
+            if (fds[i] < 0)
+                continue;
+            ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+            uint64_t v[3]{}; // value, time enabled, time running
+            if (read(fds[i], v, sizeof(v)) != sizeof(v))
+                continue;
+            res[i] = v[2] ? 1.0 * v[0] * v[1] / v[2] : 0.0;
+        }
+#endif
+        return res;
+    }
+
+    ~PerfCounters()
+    {
+#if CONDUIT_BENCH_HAS_PERF
+        for (auto fd : fds)
+            if (fd >= 0)
+                close(fd);
+#endif
+    }
+
+  private:
+    std::array<int, nCounters> fds;
+    bool anyOpen{false};
+
+    PerfCounters()
+    {
+        fds.fill(-1);
+#if CONDUIT_BENCH_HAS_PERF
+        if (!std::getenv("CONDUIT_BENCH_PERF"))
+            return;
+
+        auto cache = [](uint64_t c, uint64_t op, uint64_t result) {
+            return c | (op << 8) | (result << 16);
+        };
+        const std::array<std::pair<uint32_t, uint64_t>, nCounters> events{{
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                                       PERF_COUNT_HW_CACHE_RESULT_MISS)},
+            {PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ,
+                                       PERF_COUNT_HW_CACHE_RESULT_MISS)},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+            {PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+                                       PERF_COUNT_HW_CACHE_RESULT_MISS)},
+        }};
+
+        for (int i = 0; i < nCounters; ++i)
+        {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = events[i].first;
+            attr.config = events[i].second;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+            anyOpen = anyOpen || fds[i] >= 0;
+        }
+        if (!anyOpen)
+            fprintf(stderr, "CONDUIT_BENCH_PERF is set but no counters could be opened; "
+                            "check /proc/sys/kernel/perf_event_paranoid\n");
+#endif
+    }
+};
+} // namespace sst::conduit::benchmarks
+
+#endif // CONDUIT_BENCHMARKS_PERF_COUNTERS_H
@@ -0,0 +1,147 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+
+/*
+ * The hardware counters around the real plugin code paths the per kernel numbers feed
+ * into: the polysynth's process with notes held, which is almost all renderVoices, and
+ * the polymetric delay's process over noise, which is its span loop. Each is reported
+ * per sample, so run with CONDUIT_BENCH_PERF=1 on Linux and read the second line.
+ *
+ * High IPC with few LLC and dTLB misses says compute bound, and the SIMD and table work
+ * is where to look; low IPC with the misses climbing says memory bound, and the layout
+ * and page size work is.
+ */
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <clap/clap.h>
+
+#include "bench-harness.h"
+#include "silent-process.h"
+
+#include "polymetric-delay/polymetric-delay.h"
+#include "polysynth/polysynth.h"
+
+namespace cb = sst::conduit::benchmarks;
+
+static constexpr double sampleRate{48000};
+static constexpr uint32_t frames{256};
+static constexpr uint64_t samples{frames * 2048};
+
+// Note ons for a chord, all at the start of the first block they are offered in
+struct HeldNotes
+{
+    std::vector<clap_event_note> notes;
+    bool sent{false};
+    clap_input_events events{};
+
+    explicit HeldNotes(int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            clap_event_note n{};
+            n.header = {sizeof(clap_event_note), 0, CLAP_CORE_EVENT_SPACE_ID,
+                        CLAP_EVENT_NOTE_ON, 0};
+            n.note_id = -1;
+            n.channel = 0;
+            n.key = (int16_t)(36 + (i * 7) % 60);
+            n.velocity = 0.8;
+            notes.push_back(n);
+        }
+
+        events.ctx = this;
+        events.size = [](const clap_input_events *e) -> uint32_t {
+            auto *h = static_cast<const HeldNotes *>(e->ctx);
+            return h->sent ? 0 : (uint32_t)h->notes.size();
+        };
+        events.get = [](const clap_input_events *e, uint32_t i) -> const clap_event_header_t * {
+            return &static_cast<const HeldNotes *>(e->ctx)->notes[i].header;
+        };
+    }
+};
+
+template <typename P> struct Running
+{
+    P *plugin{new P(&cb::nullHost)};
+    const clap_plugin *cp{plugin->clapPlugin()};
+    cb::SilentProcess proc{cb::portChannels(cp, true), cb::portChannels(cp, false), frames};
+
+    Running()
+    {
+        cp->init(cp);
+        cp->activate(cp, sampleRate, 1, frames);
+        cp->start_processing(cp);
+    }
+    ~Running()
+    {
+        cp->stop_processing(cp);
+        cp->deactivate(cp);
+        cp->destroy(cp);
+    }
+
+    void run(uint64_t n)
+    {
+        for (uint64_t s = 0; s < n; s += frames)
+            cp->process(cp, &proc.process);
+    }
+};
+
+void polysynth(int nNotes)
+{
+    Running<sst::conduit::polysynth::ConduitPolysynth> synth;
+    HeldNotes held(nNotes);
+    synth.proc.process.in_events = &held.events;
+    synth.run(frames);
+    held.sent = true;
+
+    cb::report(cb::run("polysynth process, " + std::to_string(nNotes) + " notes held",
+                       samples, [&](uint64_t n) { synth.run(n); }));
+}
+
+void polymetricDelay()
+{
+    Running<sst::conduit::polymetric_delay::ConduitPolymetricDelay> delay;
+    std::minstd_rand gen(2112);
+    std::uniform_real_distribution<float> d(-0.5f, 0.5f);
+    for (uint32_t c = 0; c < 2; ++c)
+    {
+        auto *in = delay.proc.input(0, c);
+        for (uint32_t s = 0; s < frames; ++s)
+            in[s] = d(gen);
+    }
+
+    // Fill the line past the longest tap so the reads see history
+    delay.run((uint64_t)sampleRate * 8);
+    cb::report(cb::run("polymetric delay process", samples, [&](uint64_t n) { delay.run(n); }));
+}
+
+int main()
+{
+    printf("%u frame blocks at %.0f Hz, per sample\n", frames, sampleRate);
+    for (auto n : {1, 8, 32})
+        polysynth(n);
+    polymetricDelay();
+    return 0;
+}
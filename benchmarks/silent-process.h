@@ -0,0 +1,136 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_BENCHMARKS_SILENT_PROCESS_H
+#define CONDUIT_BENCHMARKS_SILENT_PROCESS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <clap/clap.h>
+
+namespace sst::conduit::benchmarks
+{
+// A host which offers no extensions and ignores every request
+inline const clap_host nullHost{
+    CLAP_VERSION_INIT,
+    nullptr,
+    "conduit-benchmarks",
+    "Surge Synth Team",
+    "",
+    "0",
+    [](const clap_host *, const char *) -> const void * { return nullptr; },
+    [](const clap_host *) {},
+    [](const clap_host *) {},
+    [](const clap_host *) {}};
+
+// The channel count of each audio port, as the plugin reports them
+inline std::vector<uint32_t> portChannels(const clap_plugin *p, bool isInput)
+{
+    std::vector<uint32_t> res;
+    auto ap = static_cast<const clap_plugin_audio_ports *>(
+        p->get_extension(p, CLAP_EXT_AUDIO_PORTS));
+    if (!ap)
+        return res;
+    for (uint32_t i = 0; i < ap->count(p, isInput); ++i)
+    {
+        clap_audio_port_info info{};
+        res.push_back(ap->get(p, i, isInput, &info) ? info.channel_count : 0);
+    }
+    return res;
+}
+
+/*
+ * A silent clap_process for driving a plugin from a benchmark: zeroed 32 bit buffers on
+ * every audio port, no input events, no transport and an output queue which drops
+ * everything. All the allocation happens in the constructor.
+ */
+struct SilentProcess
+{
+    static constexpr uint32_t maxFrames{256};
+
+    SilentProcess(const std::vector<uint32_t> &inChannels,
+                  const std::vector<uint32_t> &outChannels, uint32_t frames)
+    {
+        frames = std::min(frames, maxFrames);
+        setupPorts(inChannels, frames, inPorts, inPointers, inStorage);
+        setupPorts(outChannels, frames, outPorts, outPointers, outStorage);
+
+        inEvents.ctx = nullptr;
+        inEvents.size = [](const clap_input_events *) -> uint32_t { return 0; };
+        inEvents.get = [](const clap_input_events *, uint32_t) -> const clap_event_header_t * {
+            return nullptr;
+        };
+        outEvents.ctx = nullptr;
+        outEvents.try_push = [](const clap_output_events *, const clap_event_header_t *) {
+            return true;
+        };
+
+        process.steady_time = -1;
+        process.frames_count = frames;
+        process.transport = nullptr;
+        process.audio_inputs = inPorts.data();
+        process.audio_outputs = outPorts.data();
+        process.audio_inputs_count = (uint32_t)inPorts.size();
+        process.audio_outputs_count = (uint32_t)outPorts.size();
+        process.in_events = &inEvents;
+        process.out_events = &outEvents;
+    }
+
+    SilentProcess(const SilentProcess &) = delete;
+    SilentProcess &operator=(const SilentProcess &) = delete;
+
+    clap_process process{};
+
+    // For benchmarks which want something other than silence going in
+    float *input(uint32_t port, uint32_t chan) { return inPointers[port][chan]; }
+
+  private:
+    static void setupPorts(const std::vector<uint32_t> &channels, uint32_t frames,
+                           std::vector<clap_audio_buffer> &ports,
+                           std::vector<std::vector<float *>> &pointers,
+                           std::vector<std::vector<float>> &storage)
+    {
+        ports.resize(channels.size());
+        pointers.resize(channels.size());
+        for (size_t p = 0; p < channels.size(); ++p)
+        {
+            for (uint32_t c = 0; c < channels[p]; ++c)
+            {
+                storage.emplace_back(frames, 0.f);
+                pointers[p].push_back(storage.back().data());
+            }
+            ports[p] = {};
+            ports[p].data32 = pointers[p].data();
+            ports[p].channel_count = channels[p];
+        }
+    }
+
+    std::vector<clap_audio_buffer> inPorts, outPorts;
+    std::vector<std::vector<float *>> inPointers, outPointers;
+    std::vector<std::vector<float>> inStorage, outStorage;
+    clap_input_events inEvents{};
+    clap_output_events outEvents{};
+};
+} // namespace sst::conduit::benchmarks
+
+#endif // CONDUIT_BENCHMARKS_SILENT_PROCESS_H
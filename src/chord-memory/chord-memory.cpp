@@ -61,6 +61,7 @@ ConduitChordMemory::ConduitChordMemory(const clap_host *host)
     configureParams();
 
     attachParam(pmKeyShift, keyShift);
+    rebuildChordTable();
 
     clapJuceShim = std::make_unique<sst::clap_juce_shim::ClapJuceShim>(this);
     clapJuceShim->setResizable(true);
@@ -108,7 +109,14 @@ clap_process_status ConduitChordMemory::process(const clap_process *process) noe
     {
         auto evt = ev->get(ev, i);
 
-        if (handleParamBaseEvents(evt))
+        if (isNoteParamEvent(evt))
+        {
+            if (evt->type == CLAP_EVENT_PARAM_VALUE)
+                forwardToChord(ov, *reinterpret_cast<const clap_event_param_value *>(evt));
+            else
+                forwardToChord(ov, *reinterpret_cast<const clap_event_param_mod *>(evt));
+        }
+        else if (handleParamBaseEvents(evt))
         {
         }
         else if (evt->space_id == CLAP_CORE_EVENT_SPACE_ID)
@@ -124,14 +132,26 @@ clap_process_status ConduitChordMemory::process(const clap_process *process) noe
 
                 if (msg == 0x90 || msg == 0x80)
                 {
-                    handleMIDI1NoteChange(ov, mevt, chan, mevt->data[1], mevt->data[2] / 127.0,
-                                          msg == 0x90);
-                    /*
-                    clap_event_midi mextra;
-                    memcpy(&mextra, mevt, sizeof(clap_event_midi));
-                    mextra.data[1] += iks;
-                    ov->try_push(ov, (const clap_event_header *)(&mextra));
-                     */
+                    // A MIDI 1 note on with zero velocity is a note off
+                    auto on = msg == 0x90 && mevt->data[2] != 0;
+                    noteChange(chan, mevt->data[1], -1, on, [ov, mevt](int16_t key, int32_t) {
+                        auto out = *mevt;
+                        out.data[1] = (uint8_t)key;
+                        ov->try_push(ov, &out.header);
+                    });
+                }
+                else if (msg == 0xA0)
+                {
+                    ov->try_push(ov, evt);
+                    if (auto chord = chordFor(chan, mevt->data[1], -1))
+                    {
+                        auto out = *mevt;
+                        for (int c = 0; c < chord->count; ++c)
+                        {
+                            out.data[1] = (uint8_t)chord->keys[c];
+                            ov->try_push(ov, &out.header);
+                        }
+                    }
                 }
                 else
                 {
@@ -142,13 +162,34 @@ clap_process_status ConduitChordMemory::process(const clap_process *process) noe
 
             case CLAP_EVENT_NOTE_ON:
             case CLAP_EVENT_NOTE_OFF:
+            case CLAP_EVENT_NOTE_CHOKE:
             {
+                // A choke ends the chord like an off; the copies keep the choke type
                 auto nevt = reinterpret_cast<const clap_event_note *>(evt);
-                handleClapNoteChange(ov, nevt, nevt->channel, nevt->key, nevt->velocity,
-                                     evt->type == CLAP_EVENT_NOTE_ON);
+                auto inChannel = nevt->channel;
+                auto inKey = nevt->key;
+                if (evt->type != CLAP_EVENT_NOTE_ON && inKey < 0 && nevt->note_id >= 0)
+                {
+                    if (auto e = noteIdMap.find(nevt->note_id))
+                    {
+                        inChannel = e->channel;
+                        inKey = e->key;
+                    }
+                }
+                noteChange(inChannel, inKey, nevt->note_id, evt->type == CLAP_EVENT_NOTE_ON,
+                           [ov, nevt](int16_t key, int32_t noteId) {
+                               auto out = *nevt;
+                               out.key = key;
+                               out.note_id = noteId;
+                               ov->try_push(ov, &out.header);
+                           });
             }
             break;
 
+            case CLAP_EVENT_NOTE_EXPRESSION:
+                forwardToChord(ov, *reinterpret_cast<const clap_event_note_expression *>(evt));
+                break;
+
             default:
                 ov->try_push(ov, evt);
                 break;
@@ -163,51 +204,192 @@ clap_process_status ConduitChordMemory::process(const clap_process *process) noe
     return CLAP_PROCESS_CONTINUE;
 }
 
-void ConduitChordMemory::handleMIDI1NoteChange(const clap_output_events *ov,
-                                               const clap_event_midi *mevt, int16_t channel,
-                                               int16_t key, double vel, bool on)
+template <typename Emit>
+void ConduitChordMemory::noteChange(int16_t channel, int16_t key, int32_t noteId, bool on,
+                                    Emit &&emit)
 {
-    auto ks = (int)std::round(*keyShift);
-    auto nk = std::clamp(key + ks, 0, 127);
+    // Wildcards and anything out of range pass straight through
+    if (channel < 0 || channel > 15 || key < 0 || key > 127)
+    {
+        emit(key, noteId);
+        return;
+    }
+
+    auto &chord = activeChords[channel][key];
+    if (on && chord.depth++ == 0)
+    {
+        const auto &table = chordTables[liveChordTable.load(std::memory_order_acquire)];
+        chord.noteId = noteId;
+        chord.count = 0;
+
+        auto addCompanion = [&](int k) {
+            if (k == key || k < 0 || k > 127)
+                return;
+            chord.keys[chord.count] = (int16_t)k;
+            chord.noteIds[chord.count] =
+                noteId < 0 ? -1 : 0x40000000 + (nextCompanionNoteId++ & 0x3FFFFFFF);
+            chord.count++;
+        };
+
+        if (table.count[key] > 0)
+        {
+            for (int c = 0; c < table.count[key]; ++c)
+                addCompanion(key + table.offsets[key][c]);
+        }
+        else
+        {
+            addCompanion(std::clamp(key + (int)std::round(*keyShift), 0, 127));
+        }
+
+        if (noteId >= 0 && chord.count > 0)
+            noteIdMap.insert(noteId, channel, key);
+    }
+
     if (updateNoteOnOffData(channel, key, on))
+        emit(key, noteId);
+    for (int c = 0; c < chord.count; ++c)
+    {
+        if (updateNoteOnOffData(channel, chord.keys[c], on))
+            emit(chord.keys[c], chord.noteIds[c]);
+    }
+
+    if (!on && chord.depth > 0 && --chord.depth == 0)
     {
-        ov->try_push(ov, (const clap_event_header *)mevt);
+        if (chord.noteId >= 0 && chord.count > 0)
+            noteIdMap.erase(chord.noteId);
+        chord.count = 0;
     }
-    if (updateNoteOnOffData(channel, nk, on))
+}
+
+template <typename Event>
+void ConduitChordMemory::forwardToChord(const clap_output_events *ov, const Event &evt)
+{
+    ov->try_push(ov, &evt.header);
+    if (auto chord = chordFor(evt.channel, evt.key, evt.note_id))
     {
-        clap_event_midi mextra;
-        memcpy(&mextra, mevt, sizeof(clap_event_midi));
-        mextra.data[1] = nk;
-        ov->try_push(ov, (const clap_event_header *)(&mextra));
+        auto out = evt;
+        for (int c = 0; c < chord->count; ++c)
+        {
+            out.key = chord->keys[c];
+            out.note_id = chord->noteIds[c];
+            ov->try_push(ov, &out.header);
+        }
     }
 }
 
-void ConduitChordMemory::handleClapNoteChange(const clap_output_events *ov,
-                                              const clap_event_note *nevt, int16_t channel,
-                                              int16_t key, double vel, bool on)
+bool ConduitChordMemory::isNoteParamEvent(const clap_event_header *evt) const
 {
-    auto ks = (int)std::round(*keyShift);
-    auto nk = std::clamp(key + ks, 0, 127);
-    if (updateNoteOnOffData(nevt->channel, nevt->key, on))
+    if (evt->space_id != CLAP_CORE_EVENT_SPACE_ID)
+        return false;
+
+    // Our own parameters are never per note, so only pass through events aimed downstream
+    if (evt->type == CLAP_EVENT_PARAM_VALUE)
     {
-        ov->try_push(ov, (const clap_event_header *)nevt);
+        auto v = reinterpret_cast<const clap_event_param_value *>(evt);
+        return (v->note_id >= 0 || v->key >= 0) && !isValidParamId(v->param_id);
     }
-    if (updateNoteOnOffData(nevt->channel, nk, on))
+    if (evt->type == CLAP_EVENT_PARAM_MOD)
     {
-        clap_event_note mextra;
-        memcpy(&mextra, nevt, sizeof(clap_event_note));
-        mextra.key = nk;
-        ov->try_push(ov, (const clap_event_header *)(&mextra));
+        auto v = reinterpret_cast<const clap_event_param_mod *>(evt);
+        return (v->note_id >= 0 || v->key >= 0) && !isValidParamId(v->param_id);
     }
+    return false;
+}
+
+const ConduitChordMemory::ActiveChord *
+ConduitChordMemory::chordFor(int16_t channel, int16_t key, int32_t noteId) const
+{
+    if (channel >= 0 && channel < 16 && key >= 0 && key < 128)
+    {
+        const auto &chord = activeChords[channel][key];
+        if (chord.count > 0 && (noteId < 0 || chord.noteId == noteId))
+            return &chord;
+        return nullptr;
+    }
+
+    if (noteId >= 0)
+    {
+        if (auto e = noteIdMap.find(noteId))
+        {
+            const auto &chord = activeChords[e->channel][e->key];
+            return chord.count > 0 ? &chord : nullptr;
+        }
+    }
+    return nullptr;
 }
 
 bool ConduitChordMemory::updateNoteOnOffData(int16_t channel, int16_t key, bool isOn)
 {
-    activeNotes[channel][key] += isOn ? 1 : -1;
-    auto an = activeNotes[channel][key];
-    CNDOUT << "After note " << (isOn ? "on" : "off") << " at " << channel << " " << key
-           << " resulting an=" << an << std::endl;
-    return isOn ? an == 1 : an == 0;
+    auto &an = activeNotes[channel][key];
+    if (isOn)
+        return ++an == 1;
+
+    // An off we never saw the on for (say from before activation) still goes out
+    if (an == 0)
+        return true;
+    return --an == 0;
+}
+
+void ConduitChordMemory::rebuildChordTable()
+{
+    auto next = 1 - liveChordTable.load();
+    auto &table = chordTables[next];
+    const auto &companions = patch.extension.companionNotes;
+
+    for (int key = 0; key < 128; ++key)
+    {
+        // bit b is the note b - 24 keys away
+        uint8_t n{0};
+        for (int b = 0; b < 49 && n < maxCompanions; ++b)
+        {
+            if (b != 24 && companions[key].test(b))
+                table.offsets[key][n++] = (int8_t)(b - 24);
+        }
+        table.count[key] = n;
+    }
+    liveChordTable.store(next, std::memory_order_release);
+}
+
+void ConduitChordMemory::NoteIdMap::insert(int32_t id, int16_t channel, int16_t key)
+{
+    auto s = slotFor(id);
+    while (entries[s].id != -1 && entries[s].id != id)
+        s = (s + 1) & (size - 1);
+    entries[s] = {id, channel, key};
+}
+
+const ConduitChordMemory::NoteIdMap::Entry *
+ConduitChordMemory::NoteIdMap::find(int32_t id) const
+{
+    auto s = slotFor(id);
+    while (entries[s].id != -1)
+    {
+        if (entries[s].id == id)
+            return &entries[s];
+        s = (s + 1) & (size - 1);
+    }
+    return nullptr;
+}
+
+void ConduitChordMemory::NoteIdMap::erase(int32_t id)
+{
+    auto e = find(id);
+    if (!e)
+        return;
+
+    // Pull later entries of the probe run back over the hole so lookups never stop early
+    uint32_t hole = e - entries.data();
+    entries[hole].id = -1;
+    for (auto j = (hole + 1) & (size - 1); entries[j].id != -1; j = (j + 1) & (size - 1))
+    {
+        auto home = slotFor(entries[j].id);
+        if (((j - home) & (size - 1)) >= ((j - hole) & (size - 1)))
+        {
+            entries[hole] = entries[j];
+            entries[j].id = -1;
+            hole = j;
+        }
+    }
 }
 
 bool ConduitChordMemoryConfig::PatchExtension::toXml(TiXmlElement &el)
@@ -224,6 +406,31 @@ bool ConduitChordMemoryConfig::PatchExtension::toXml(TiXmlElement &el)
     return true;
 }
 
-bool ConduitChordMemoryConfig::PatchExtension::fromXml(TiXmlElement *) { return true; }
+bool ConduitChordMemoryConfig::PatchExtension::fromXml(TiXmlElement *el)
+{
+    for (auto &c : companionNotes)
+        c.reset();
+
+    auto cn = TINYXML_SAFE_TO_ELEMENT(el->FirstChild("companionNotes"));
+    if (!cn)
+        return true;
+
+    auto nt = TINYXML_SAFE_TO_ELEMENT(cn->FirstChild("note"));
+    while (nt)
+    {
+        int n;
+        auto b = nt->Attribute("b");
+        if (nt->QueryIntAttribute("n", &n) == TIXML_SUCCESS && n >= 0 &&
+            n < (int)companionNotes.size() && b && strlen(b) == companionNotes[n].size())
+        {
+            // to_string writes the highest bit first
+            auto &bits = companionNotes[n];
+            for (size_t i = 0; i < bits.size(); ++i)
+                bits[bits.size() - 1 - i] = b[i] == '1';
+        }
+        nt = TINYXML_SAFE_TO_ELEMENT(nt->NextSiblingElement("note"));
+    }
+    return true;
+}
 
 } // namespace sst::conduit::chord_memory
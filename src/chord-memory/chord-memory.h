@@ -26,6 +26,7 @@
 #include <atomic>
 #include <array>
 #include <bitset>
+#include <cstdint>
 #include <unordered_map>
 #include <memory>
 
@@ -43,6 +44,7 @@ struct ConduitChordMemoryConfig
     static constexpr int nParams{sst::conduit::chord_memory::nParams};
     static constexpr bool baseClassProvidesMonoModSupport{true};
     static constexpr bool usesSpecializedMessages{false};
+    static constexpr bool primeOnActivate{false};
     struct PatchExtension
     {
         static constexpr bool hasExtension{true};
@@ -103,16 +105,83 @@ struct ConduitChordMemory
     std::unique_ptr<juce::Component> createEditor() override;
     std::atomic<bool> refreshUIValues{false};
 
-    std::array<std::array<float, 128>, 16> activeNotes{};
-    std::array<std::array<std::bitset<128>, 128>, 16> notesStartedFromParent{};
+    // How many sounding notes, input or companion, want each output channel and key
+    std::array<std::array<uint16_t, 128>, 16> activeNotes{};
 
-    // Generate 0 or more output note events from a single input note event
-    void handleMIDI1NoteChange(const clap_output_events *ov, const clap_event_midi *under,
-                               int16_t channel, int16_t key, double vel, bool on);
-    void handleClapNoteChange(const clap_output_events *ov, const clap_event_note *under,
-                              int16_t channel, int16_t key, double vel, bool on);
-
-    // If these return TRUE then you need to send a note on or off out.
+    /*
+     * The chord for each key as note offsets, built from the patch companion note bitsets
+     * on the main thread. A key with no companions set falls back to the key shift. There
+     * are two tables so a rebuild never tears the one the audio thread is reading.
+     */
+    static constexpr int maxCompanions{16};
+    struct ChordTable
+    {
+        std::array<std::array<int8_t, maxCompanions>, 128> offsets{};
+        std::array<uint8_t, 128> count{};
+    };
+    std::array<ChordTable, 2> chordTables{};
+    std::atomic<int> liveChordTable{0};
+    void rebuildChordTable();
+    void onStateRestored() override { rebuildChordTable(); }
+
+    /*
+     * A sounding chord, by the input channel and key which started it. The companions are
+     * fixed when it starts, so the release matches even if the table changes meanwhile.
+     * Companions of a note with an id get ids of their own, so expressions aimed at the
+     * input note can be copied to each companion.
+     */
+    struct ActiveChord
+    {
+        uint16_t depth{0}; // overlapping note ons of the same key
+        int32_t noteId{-1};
+        uint8_t count{0};
+        std::array<int16_t, maxCompanions> keys{};
+        std::array<int32_t, maxCompanions> noteIds{};
+    };
+    std::array<std::array<ActiveChord, 128>, 16> activeChords{};
+    int32_t nextCompanionNoteId{0};
+
+    /*
+     * Input note id to the channel and key of its chord, for expressions which address a
+     * note by id alone. Open addressed with backward shift deletion; fixed size, since
+     * there are never more than 16 * 128 chords.
+     */
+    struct NoteIdMap
+    {
+        static constexpr int size{4096};
+        struct Entry
+        {
+            int32_t id{-1};
+            int16_t channel{0}, key{0};
+        };
+        std::array<Entry, size> entries{};
+
+        void insert(int32_t id, int16_t channel, int16_t key);
+        const Entry *find(int32_t id) const;
+        void erase(int32_t id);
+
+      private:
+        static uint32_t slotFor(int32_t id) { return ((uint32_t)id * 2654435761U) & (size - 1); }
+    } noteIdMap;
+
+    /*
+     * Updates the chord and note counts for an input note on or off, then calls
+     * emit(key, noteId) for the input note and each companion whose output should start
+     * or stop.
+     */
+    template <typename Emit>
+    void noteChange(int16_t channel, int16_t key, int32_t noteId, bool on, Emit &&emit);
+
+    // The chord an expression or aftertouch for this note should be copied to, if any
+    const ActiveChord *chordFor(int16_t channel, int16_t key, int32_t noteId) const;
+
+    // Sends a note addressed event on, followed by a copy for each companion of its chord
+    template <typename Event> void forwardToChord(const clap_output_events *ov, const Event &evt);
+
+    // A param value or mod aimed at a note of the plugin downstream, rather than at us
+    bool isNoteParamEvent(const clap_event_header *evt) const;
+
+    // If this returns true you need to send a note on or off out
     bool updateNoteOnOffData(int16_t channel, int16_t key, bool isOn);
 
   public:
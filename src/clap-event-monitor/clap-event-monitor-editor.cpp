@@ -76,7 +76,13 @@ struct ConduitClapEventMonitorEditor : public sst::jucegui::accessibility::Ignor
         auto tp = std::make_unique<TransportPainter>(this);
         transportPanel->setContentAreaComponent(std::move(tp));
 
-        setSize(800, 700);
+        countersPanel = std::make_unique<jcmp::NamedPanel>("Counters");
+        addAndMakeVisible(*countersPanel);
+        auto cp = std::make_unique<CountersPainter>(*this);
+        countersPainterWeak = cp.get();
+        countersPanel->setContentAreaComponent(std::move(cp));
+
+        setSize(800, 900);
     }
 
     ~ConduitClapEventMonitorEditor()
@@ -110,6 +116,8 @@ struct ConduitClapEventMonitorEditor : public sst::jucegui::accessibility::Ignor
         }
         if (dorp)
             eventPainterWeak->lb->updateContent();
+        if (uic.dataCopyForUI.countersMode)
+            countersPainterWeak->repaint();
     }
 
     struct TransportPainter : juce::Component
@@ -182,6 +190,123 @@ struct ConduitClapEventMonitorEditor : public sst::jucegui::accessibility::Ignor
         }
     };
 
+    /*
+     * The counters mode switch, the 1 in N sampling choice and a snapshot of the counters,
+     * read straight from the atomics each repaint. Click the table to reset.
+     */
+    struct CountersPainter : juce::Component
+    {
+        ConduitClapEventMonitorEditor &editor;
+        juce::ToggleButton mode{"Counters Only"};
+        juce::ComboBox sampling;
+
+        static constexpr uint32_t samplingChoices[]{0, 10, 100, 1000};
+
+        CountersPainter(ConduitClapEventMonitorEditor &e) : editor(e)
+        {
+            auto &dc = editor.uic.dataCopyForUI;
+            mode.setToggleState(dc.countersMode, juce::dontSendNotification);
+            mode.onClick = [this]() {
+                editor.uic.dataCopyForUI.countersMode = mode.getToggleState();
+                repaint();
+            };
+            addAndMakeVisible(mode);
+
+            int sel{1};
+            for (auto c : samplingChoices)
+            {
+                sampling.addItem(c == 0 ? "No events" : "1 in " + std::to_string(c) + " events",
+                                 sel);
+                if (c == dc.sampleEvery)
+                    sampling.setSelectedId(sel, juce::dontSendNotification);
+                sel++;
+            }
+            sampling.onChange = [this]() {
+                auto idx = std::clamp(sampling.getSelectedId() - 1, 0, 3);
+                editor.uic.dataCopyForUI.sampleEvery = samplingChoices[idx];
+            };
+            addAndMakeVisible(sampling);
+        }
+
+        void resized() override
+        {
+            mode.setBounds(0, 0, 140, 20);
+            sampling.setBounds(150, 0, 160, 20);
+        }
+
+        void mouseDown(const juce::MouseEvent &) override
+        {
+            editor.uic.dataCopyForUI.counters.resetRequested = true;
+        }
+
+        void paint(juce::Graphics &g) override
+        {
+            const auto &dc = editor.uic.dataCopyForUI;
+            g.setColour(juce::Colours::white);
+            g.setFont(juce::FontOptions(editor.fixedFace).withHeight(11));
+            if (!dc.countersMode)
+            {
+                g.drawText("Copying every event", 0, 24, getWidth(), 18,
+                           juce::Justification::centredLeft);
+                return;
+            }
+
+            static constexpr const char *typeNames[]{
+                "NOTE_ON",     "NOTE_OFF",      "NOTE_CHOKE",    "NOTE_END",
+                "NOTE_EXPR",   "PARAM_VALUE",   "PARAM_MOD",     "GESTURE_BEGIN",
+                "GESTURE_END", "TRANSPORT",     "MIDI",          "MIDI_SYSEX",
+                "MIDI2"};
+            const auto &c = dc.counters;
+
+            int yp{24}, xp{0};
+            auto line = [&](const std::string &txt) {
+                g.drawText(txt, xp, yp, getWidth() / 2 - 4, 14, juce::Justification::centredLeft);
+                yp += 14;
+            };
+
+            char buf[128];
+            line("type              count   min gap   max gap");
+            for (int t = 0; t < (int)std::size(typeNames); ++t)
+            {
+                const auto &pt = c.perType[t];
+                auto n = pt.count.load(std::memory_order_relaxed);
+                if (n == 0)
+                    continue;
+                auto mn = pt.minGap.load(std::memory_order_relaxed);
+                snprintf(buf, sizeof(buf), "%-14s %8llu  %8lld  %8llu", typeNames[t],
+                         (unsigned long long)n,
+                         mn == EventCounters::noGap ? -1LL : (long long)mn,
+                         (unsigned long long)pt.maxGap.load(std::memory_order_relaxed));
+                line(buf);
+            }
+            snprintf(buf, sizeof(buf), "%-14s %8llu", "non core",
+                     (unsigned long long)c.nonCore.load(std::memory_order_relaxed));
+            line(buf);
+
+            xp = getWidth() / 2;
+            yp = 24;
+            line("param                    values      mods");
+            auto pds = editor.uic.getAllParamDescriptions();
+            for (int i = 0; i < nParams && i < (int)pds.size(); ++i)
+            {
+                snprintf(buf, sizeof(buf), "%-22.22s %8llu  %8llu", pds[i].name.c_str(),
+                         (unsigned long long)c.paramValues[i].load(std::memory_order_relaxed),
+                         (unsigned long long)c.paramMods[i].load(std::memory_order_relaxed));
+                line(buf);
+            }
+            yp += 6;
+            for (int ch = 0; ch < 16; ch += 4)
+            {
+                snprintf(buf, sizeof(buf), "ch %2d-%2d %7llu %7llu %7llu %7llu", ch + 1, ch + 4,
+                         (unsigned long long)c.perChannel[ch].load(std::memory_order_relaxed),
+                         (unsigned long long)c.perChannel[ch + 1].load(std::memory_order_relaxed),
+                         (unsigned long long)c.perChannel[ch + 2].load(std::memory_order_relaxed),
+                         (unsigned long long)c.perChannel[ch + 3].load(std::memory_order_relaxed));
+                line(buf);
+            }
+        }
+    };
+
     struct EventPainter : juce::Component, juce::TableListBoxModel // a bit sloppy but that's OK
     {
         const ConduitClapEventMonitorEditor &editor;
@@ -344,13 +469,16 @@ struct ConduitClapEventMonitorEditor : public sst::jucegui::accessibility::Ignor
 
     void resized() override
     {
-        auto spl = 180;
+        auto spl = 180, cspl = 260;
         if (evtPanel)
-            evtPanel->setBounds(getLocalBounds().withTrimmedTop(spl));
+            evtPanel->setBounds(getLocalBounds().withTrimmedTop(spl + cspl));
         if (transportPanel)
             transportPanel->setBounds(getLocalBounds().withHeight(spl));
+        if (countersPanel)
+            countersPanel->setBounds(getLocalBounds().withTrimmedTop(spl).withHeight(cspl));
     }
-    std::unique_ptr<jcmp::NamedPanel> evtPanel, transportPanel;
+    std::unique_ptr<jcmp::NamedPanel> evtPanel, transportPanel, countersPanel;
+    CountersPainter *countersPainterWeak{nullptr};
     std::deque<ConduitClapEventMonitorConfig::DataCopyForUI::evtCopy> events;
     EventPainter *eventPainterWeak{nullptr};
     juce::Typeface::Ptr fixedFace{nullptr};
@@ -130,15 +130,125 @@ clap_process_status ConduitClapEventMonitor::process(const clap_process *process
     {
         samplePos = 0;
     }
-    for (auto i = 0U; i < sz; ++i)
+
+    auto &dc = uiComms.dataCopyForUI;
+    if (!dc.countersMode.load(std::memory_order_relaxed))
     {
-        auto et = ev->get(ev, i);
-        uiComms.dataCopyForUI.writeEventTo(et);
+        for (auto i = 0U; i < sz; ++i)
+        {
+            auto et = ev->get(ev, i);
+            dc.writeEventTo(et);
 
-        ov->try_push(ov, et);
+            ov->try_push(ov, et);
+        }
+    }
+    else
+    {
+        if (dc.counters.resetRequested.exchange(false))
+            dc.counters.reset();
+
+        auto blockStart = dc.processedSamples.load(std::memory_order_relaxed);
+        auto every = dc.sampleEvery.load(std::memory_order_relaxed);
+        for (auto i = 0U; i < sz; ++i)
+        {
+            auto et = ev->get(ev, i);
+
+            int paramIndex{-1};
+            if (et->space_id == CLAP_CORE_EVENT_SPACE_ID &&
+                (et->type == CLAP_EVENT_PARAM_VALUE || et->type == CLAP_EVENT_PARAM_MOD))
+            {
+                // param_id sits at the same offset in both
+                auto pv = reinterpret_cast<const clap_event_param_value *>(et);
+                auto pi = paramToPatchIndex.find(pv->param_id);
+                if (pi != paramToPatchIndex.end())
+                    paramIndex = pi->second;
+            }
+            dc.counters.count(et, blockStart + et->time, paramIndex);
+
+            if (every > 0 && sampleCountdown-- == 0)
+            {
+                sampleCountdown = every - 1;
+                dc.writeEventTo(et);
+            }
+
+            ov->try_push(ov, et);
+        }
     }
+    dc.processedSamples.store(dc.processedSamples.load(std::memory_order_relaxed) +
+                                  process->frames_count,
+                              std::memory_order_relaxed);
 
     return CLAP_PROCESS_CONTINUE;
 }
 
+void EventCounters::count(const clap_event_header_t *e, uint64_t at, int paramIndex)
+{
+    if (e->space_id != CLAP_CORE_EVENT_SPACE_ID || e->type >= nTypes)
+    {
+        bump(nonCore);
+        return;
+    }
+
+    auto &pt = perType[e->type];
+    bump(pt.count);
+    if (seen[e->type])
+    {
+        auto gap = at - lastAt[e->type];
+        if (gap < pt.minGap.load(std::memory_order_relaxed))
+            pt.minGap.store(gap, std::memory_order_relaxed);
+        if (gap > pt.maxGap.load(std::memory_order_relaxed))
+            pt.maxGap.store(gap, std::memory_order_relaxed);
+    }
+    seen[e->type] = true;
+    lastAt[e->type] = at;
+
+    int channel{-1};
+    switch (e->type)
+    {
+    case CLAP_EVENT_NOTE_ON:
+    case CLAP_EVENT_NOTE_OFF:
+    case CLAP_EVENT_NOTE_CHOKE:
+    case CLAP_EVENT_NOTE_END:
+        channel = reinterpret_cast<const clap_event_note *>(e)->channel;
+        break;
+    case CLAP_EVENT_NOTE_EXPRESSION:
+        channel = reinterpret_cast<const clap_event_note_expression *>(e)->channel;
+        break;
+    case CLAP_EVENT_PARAM_VALUE:
+        channel = reinterpret_cast<const clap_event_param_value *>(e)->channel;
+        if (paramIndex >= 0)
+            bump(paramValues[paramIndex]);
+        break;
+    case CLAP_EVENT_PARAM_MOD:
+        channel = reinterpret_cast<const clap_event_param_mod *>(e)->channel;
+        if (paramIndex >= 0)
+            bump(paramMods[paramIndex]);
+        break;
+    case CLAP_EVENT_MIDI:
+        channel = reinterpret_cast<const clap_event_midi *>(e)->data[0] & 0x0F;
+        break;
+    }
+    if (channel >= 0 && channel < 16)
+        bump(perChannel[channel]);
+}
+
+void EventCounters::reset()
+{
+    for (auto &pt : perType)
+    {
+        pt.count.store(0, std::memory_order_relaxed);
+        pt.minGap.store(noGap, std::memory_order_relaxed);
+        pt.maxGap.store(0, std::memory_order_relaxed);
+    }
+    nonCore.store(0, std::memory_order_relaxed);
+    for (auto &c : perChannel)
+        c.store(0, std::memory_order_relaxed);
+    for (int i = 0; i < nParams; ++i)
+    {
+        paramValues[i].store(0, std::memory_order_relaxed);
+        paramMods[i].store(0, std::memory_order_relaxed);
+    }
+    seen.fill(false);
+}
+
 } // namespace sst::conduit::clap_event_monitor
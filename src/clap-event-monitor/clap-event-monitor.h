@@ -38,11 +38,50 @@ namespace sst::conduit::clap_event_monitor
 {
 static constexpr int nParams = 3;
 
+/*
+ * The counters capture mode keeps only these, rather than copying each event to the UI,
+ * so a whole session of automation and modulation can be watched for next to nothing.
+ * The audio thread is the only writer, so the updates are plain relaxed loads and stores,
+ * and the UI reads them as a (not quite atomic) snapshot whenever it likes. Gaps are
+ * between consecutive events of a type, in samples since processing started.
+ */
+struct EventCounters
+{
+    static constexpr int nTypes{16}; // the core event types; CLAP_EVENT_MIDI2 is 12
+    static constexpr uint64_t noGap{~0ULL};
+
+    struct PerType
+    {
+        std::atomic<uint64_t> count{0}, minGap{noGap}, maxGap{0};
+    };
+    std::array<PerType, nTypes> perType{};
+    std::atomic<uint64_t> nonCore{0};
+    std::array<std::atomic<uint64_t>, 16> perChannel{};
+    std::array<std::atomic<uint64_t>, nParams> paramValues{}, paramMods{};
+
+    // Set by the UI; the audio thread zeroes everything at its next process
+    std::atomic<bool> resetRequested{false};
+
+    // Audio thread only. paramIndex is the patch index of a param event's target, or -1
+    void count(const clap_event_header_t *e, uint64_t at, int paramIndex);
+    void reset();
+
+  private:
+    static void bump(std::atomic<uint64_t> &a)
+    {
+        a.store(a.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    std::array<uint64_t, nTypes> lastAt{};
+    std::array<bool, nTypes> seen{};
+};
+
 struct ConduitClapEventMonitorConfig
 {
     static constexpr int nParams{sst::conduit::clap_event_monitor::nParams};
     static constexpr bool baseClassProvidesMonoModSupport{true};
     static constexpr bool usesSpecializedMessages{false};
+    static constexpr bool primeOnActivate{false};
     using PatchExtension = sst::conduit::shared::EmptyPatchExtension;
     struct DataCopyForUI
     {
@@ -50,6 +89,11 @@ struct ConduitClapEventMonitorConfig
         std::atomic<bool> isProcessing{false};
 
         std::atomic<uint64_t> processedSamples{0};
+
+        // Set from the UI. In counters mode, sampleEvery > 0 still copies 1 in N events.
+        std::atomic<bool> countersMode{false};
+        std::atomic<uint32_t> sampleEvery{0};
+        EventCounters counters;
         static constexpr uint32_t maxEventSize{4096}, maxEvents{4096};
 
         struct evtCopy
@@ -144,6 +188,7 @@ struct ConduitClapEventMonitor
     std::atomic<bool> refreshUIValues{false};
 
     uint64_t samplePos{0};
+    uint32_t sampleCountdown{0};
 };
 } // namespace sst::conduit::clap_event_monitor
 
@@ -0,0 +1,91 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_SRC_CONDUIT_SHARED_AUDIO_PORT_IO_H
+#define CONDUIT_SRC_CONDUIT_SHARED_AUDIO_PORT_IO_H
+
+#include <cstdint>
+
+#include <clap/clap.h>
+
+#include "sse-include.h"
+
+namespace sst::conduit::shared
+{
+/*
+ * Ports which advertise CLAP_AUDIO_PORT_SUPPORTS_64BITS can be handed either data32 or
+ * data64 by the host, so rather than converting in a separate pass we read and write
+ * through these at the point the plugin already copies between host buffers and its own
+ * float working buffers.
+ *
+ * Both convert four samples at a time with SSE2. Sample accurate loops work on float
+ * spans and convert each span on the way in and out rather than per sample.
+ */
+inline bool isDouble(const clap_audio_buffer &b) { return !b.data32 && b.data64; }
+
+inline void storeSpan(const clap_audio_buffer &b, uint32_t chan, uint32_t offset,
+                      const float *src, uint32_t n)
+{
+    if (!isDouble(b))
+    {
+        auto *d = b.data32[chan] + offset;
+        for (uint32_t i = 0; i < n; ++i)
+            d[i] = src[i];
+        return;
+    }
+
+    auto *d = b.data64[chan] + offset;
+    uint32_t i{0};
+    for (; i + 4 <= n; i += 4)
+    {
+        auto v = _mm_loadu_ps(src + i);
+        _mm_storeu_pd(d + i, _mm_cvtps_pd(v));
+        _mm_storeu_pd(d + i + 2, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+    }
+    for (; i < n; ++i)
+        d[i] = src[i];
+}
+
+inline void loadSpan(const clap_audio_buffer &b, uint32_t chan, uint32_t offset, float *dst,
+                     uint32_t n)
+{
+    if (!isDouble(b))
+    {
+        const auto *s = b.data32[chan] + offset;
+        for (uint32_t i = 0; i < n; ++i)
+            dst[i] = s[i];
+        return;
+    }
+
+    const auto *s = b.data64[chan] + offset;
+    uint32_t i{0};
+    for (; i + 4 <= n; i += 4)
+    {
+        auto lo = _mm_cvtpd_ps(_mm_loadu_pd(s + i));
+        auto hi = _mm_cvtpd_ps(_mm_loadu_pd(s + i + 2));
+        _mm_storeu_ps(dst + i, _mm_movelh_ps(lo, hi));
+    }
+    for (; i < n; ++i)
+        dst[i] = (float)s[i];
+}
+} // namespace sst::conduit::shared
+
+#endif // CONDUIT_SRC_CONDUIT_SHARED_AUDIO_PORT_IO_H
@@ -22,6 +22,8 @@
 #ifndef CONDUIT_SRC_CONDUIT_SHARED_CLAP_BASE_CLASS_H
 #define CONDUIT_SRC_CONDUIT_SHARED_CLAP_BASE_CLASS_H
 
+#include <array>
+#include <cmath>
 #include <cstdint>
 #include <vector>
 #include <unordered_map>
@@ -48,6 +50,10 @@
 #include <sst/basic-blocks/params/ParamMetadata.h>
 #include <sst/clap_juce_shim/clap_juce_shim.h>
 #include "debug-helpers.h"
+#include "derived-value.h"
+#include "param-ramps.h"
+#include "param-text-cache.h"
+#include "warm-up.h"
 
 namespace sst::conduit::shared
 {
@@ -122,6 +128,12 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
             paramToValue[pd.id] = &(patch.params[patchIdx]);
 
             patch.params[patchIdx] = pd.defaultVal;
+            paramRamps.rampable[patchIdx] = !(pd.flags & CLAP_PARAM_IS_STEPPED);
+
+            auto &di = paramDisplayInfo[patchIdx];
+            auto range = (double)pd.maxVal - pd.minVal;
+            di.desc = &pd;
+            di.quantum = (range > 0 ? range : 1.0) * 1e-7;
             if (TConfig::baseClassProvidesMonoModSupport)
             {
                 monoModulatedPatch.update(patchIdx, patch);
@@ -131,6 +143,7 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
         }
         cbassert(paramDescriptionMap.size() == TConfig::nParams, "Bad Traversal");
         cbassert(patchIdx == TConfig::nParams, "Bad Traversal");
+        resolveTemposyncDisplay();
     }
 
     bool implementsParams() const noexcept override { return true; }
@@ -158,8 +171,8 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
     bool paramsValueToText(clap_id paramId, double value, char *display,
                            uint32_t size) noexcept override
     {
-        auto sValue = paramValueDisplay(paramId, value);
-        if (sValue.has_value())
+        auto sValue = cachedParamText(paramId, value);
+        if (sValue)
         {
             strncpy(display, sValue->c_str(), size);
             return true;
@@ -169,26 +182,64 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
 
     std::optional<std::string> paramValueDisplay(clap_id paramId, double value) const
     {
-        auto pos = paramDescriptionMap.find(paramId);
-        if (pos == paramDescriptionMap.end())
+        auto sValue = cachedParamText(paramId, value);
+        if (!sValue)
             return std::nullopt;
+        return *sValue;
+    }
+
+    /*
+     * Hosts redrawing automation lanes call value to text constantly, so we keep the
+     * descriptor and temposync buddy for each parameter flat by patch index and cache the
+     * last few strings per parameter, keyed by the value quantized to 1e-7 of its range
+     * and the temposync state. Main thread only; the pointer is good until the next call.
+     */
+    struct ParamDisplayInfo
+    {
+        const ParamDesc *desc{nullptr};
+        const float *temposyncValue{nullptr};
+        double quantum{1.0};
+    };
+    std::array<ParamDisplayInfo, TConfig::nParams> paramDisplayInfo{};
+    mutable std::array<ParamTextCache<>, TConfig::nParams> paramTextCache{};
+    mutable std::string paramTextScratch;
+
+    const std::string *cachedParamText(clap_id paramId, double value) const
+    {
+        auto ptpi = paramToPatchIndex.find(paramId);
+        if (ptpi == paramToPatchIndex.end())
+            return nullptr;
+
+        const auto &di = paramDisplayInfo[ptpi->second];
+        auto &cache = paramTextCache[ptpi->second];
 
-        const auto &pd = pos->second;
         ParamDesc::FeatureState fs;
+        bool isTS{false};
+        if (di.temposyncValue)
+        {
+            isTS = *(di.temposyncValue) > 0.5;
+            fs = fs.withTemposync(isTS);
+        }
 
-        auto tsBuddy = temposyncActivatedBy.find(paramId);
-        if (tsBuddy != temposyncActivatedBy.end())
+        // non finite or absurd values skip the cache rather than overflow the key
+        auto q = value / di.quantum;
+        bool cacheable = std::fabs(q) < 1e15;
+        auto key = cacheable ? std::llround(q) * 2 + (isTS ? 1 : 0) : 0;
+        if (cacheable)
         {
-            auto pvIt = paramToValue.find(tsBuddy->second);
-            if (pvIt != paramToValue.end())
-            {
-                auto isTS = *(pvIt->second) > 0.5;
-                fs = fs.withTemposync(isTS);
-            }
+            if (auto hit = cache.find(key))
+                return hit;
         }
 
-        auto sValue = pd.valueToString(value, fs);
-        return sValue;
+        auto sValue = di.desc->valueToString(value, fs);
+        if (!sValue.has_value())
+            return nullptr;
+        if (!cacheable)
+        {
+            paramTextScratch = std::move(*sValue);
+            return &paramTextScratch;
+        }
+        return &cache.insert(key, *sValue);
     }
 
     bool paramsTextToValue(clap_id paramId, const char *display, double *value) noexcept override
@@ -213,6 +264,21 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
     void addTemposyncActivator(clap_id toThis, clap_id byThat)
     {
         temposyncActivatedBy[toThis] = byThat;
+        resolveTemposyncDisplay();
+    }
+
+    // A no-op until configureParams has built the patch index
+    void resolveTemposyncDisplay()
+    {
+        for (const auto &[toThis, byThat] : temposyncActivatedBy)
+        {
+            auto to = paramToPatchIndex.find(toThis);
+            auto by = paramToPatchIndex.find(byThat);
+            if (to != paramToPatchIndex.end() && by != paramToPatchIndex.end())
+                paramDisplayInfo[to->second].temposyncValue = &patch.params[by->second];
+        }
+        for (auto &c : paramTextCache)
+            c.clear();
     }
 
     struct Patch
@@ -238,6 +304,98 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
     std::unordered_map<clap_id, float *> paramToValue;
     std::unordered_map<clap_id, int> paramToPatchIndex;
 
+    /*
+     * Bumped by patch index every time a parameter's value or mono modulation changes,
+     * including on state load, so derived state can be recomputed only when needed.
+     * See DerivedValue.
+     */
+    std::array<uint32_t, TConfig::nParams> paramVersions{};
+
+    const uint32_t *paramVersion(clap_id paramId) const
+    {
+        auto ptpi = paramToPatchIndex.find(paramId);
+        if (ptpi == paramToPatchIndex.end())
+            return nullptr;
+        return &paramVersions[ptpi->second];
+    }
+
+    /*
+     * Block based plugins can call scanParamRamps with the inbound events at the top of
+     * process and applyParamRamps at each block boundary so dense automation is followed
+     * as a ramp rather than a step at the next block. See ParamRampStage.
+     */
+    ParamRampStage<TConfig::nParams> paramRamps;
+
+    void scanParamRamps(const clap_input_events *in)
+    {
+        paramRamps.scan(in, [this](clap_id id) {
+            auto ptpi = paramToPatchIndex.find(id);
+            return ptpi == paramToPatchIndex.end() ? -1 : ptpi->second;
+        });
+    }
+
+    template <typename F>
+    void applyParamRamps(uint32_t blockStart, uint32_t blockEnd, F &&onApplied)
+    {
+        if (paramRamps.empty())
+            return;
+
+        paramRamps.advance(blockStart, blockEnd, [&](clap_id id, float value) {
+            doValueUpdate(id, value);
+            sendParamValueToUI(id, value);
+            onApplied(id, value);
+        });
+    }
+
+    void applyParamRamps(uint32_t blockStart, uint32_t blockEnd)
+    {
+        applyParamRamps(blockStart, blockEnd, [](clap_id, float) {});
+    }
+
+    // A value event on a ramp is applied by applyParamRamps, so process should skip it
+    bool paramRampCovers(const clap_event_param_value *v) const
+    {
+        return paramRamps.covers(v->param_id, v->header.time);
+    }
+
+    template <size_t N>
+    void attachDerived(DerivedValue<N> &to, const std::array<clap_id, N> &paramIds)
+    {
+        for (size_t i = 0; i < N; ++i)
+        {
+            to.sources[i] = paramVersion(paramIds[i]);
+        }
+        to.invalidate();
+    }
+
+    /*
+     * Call at the end of activate. Otherwise the first process calls fault in pages and
+     * miss on cold buffers, on the audio thread. A plugin lists its big buffers by
+     * defining forEachWarmUpRegion(f), calling f(pointer, bytes) for each, and every page
+     * of those is touched here on the main thread. If the config sets primeOnActivate we
+     * also call the plugin's primeKernels() a few times, which runs its DSP code over
+     * silence to pull in the code, tables and the rest of the state. That is not process:
+     * it must not touch the UI queues or events, and must put back anything it advances.
+     */
+    bool warmUpOnActivate{true}; // so the instantiation benchmark can compare
+    static constexpr int primeBlocks{4};
+
+    void warmUp()
+    {
+        if (!warmUpOnActivate)
+            return;
+
+        static_cast<T *>(this)->forEachWarmUpRegion(touchPages);
+
+        if constexpr (TConfig::primeOnActivate)
+        {
+            for (int i = 0; i < primeBlocks; ++i)
+                static_cast<T *>(this)->primeKernels();
+        }
+    }
+
+    template <typename F> void forEachWarmUpRegion(F &&) {}
+
     using lag_t = sst::basic_blocks::dsp::SurgeLag<float, true>;
     std::unordered_map<clap_id, lag_t *> paramToLag;
 
@@ -293,6 +451,7 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
     // This is an OK default implementation but you may want to replace it
     void paramsFlush(const clap_input_events *in, const clap_output_events *out) noexcept override
     {
+        paramRamps.clear();
         auto sz = in->size(in);
 
         for (auto e = 0U; e < sz; ++e)
@@ -355,29 +514,22 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
     }
     bool stateLoad(const clap_istream *istream) noexcept override
     {
-        static constexpr uint32_t maxSize = 1 << 16, chunkSize = 1 << 8;
-        char buffer[maxSize];
-        char *bp = &(buffer[0]);
+        // Read onto the heap; multi-part patches can be well beyond a comfortable stack size
+        static constexpr uint32_t maxSize = 1 << 24, chunkSize = 1 << 12;
+        char chunk[chunkSize];
         int64_t rd{0};
-        int64_t totalRd{0};
 
-        buffer[0] = 0;
-        while ((rd = istream->read(istream, bp, chunkSize)) > 0)
+        std::string xd;
+        while ((rd = istream->read(istream, chunk, chunkSize)) > 0)
         {
-            bp += rd;
-            totalRd += rd;
-            if (totalRd >= maxSize - chunkSize - 1)
+            xd.append(chunk, rd);
+            if (xd.size() >= maxSize)
             {
                 CNDOUT << "Input byte stream larger than " << maxSize << "; Failing" << std::endl;
                 return false;
             }
         }
 
-        if (totalRd < maxSize)
-            buffer[totalRd] = 0;
-
-        auto xd = std::string(buffer);
-
         TiXmlDocument document;
         // I forget how to error check this.
         document.Parse(xd.c_str());
@@ -502,6 +654,10 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
         {
             monoModulatedPatch.updateAll(patch);
         }
+        for (auto &v : paramVersions)
+        {
+            v++;
+        }
         onStateRestored();
         return true;
     }
@@ -751,6 +907,7 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
 
         int index = ptpi->second;
         patch.params[index] = value;
+        paramVersions[index]++;
         if (TConfig::baseClassProvidesMonoModSupport)
         {
             monoModulatedPatch.update(index, patch);
@@ -779,6 +936,7 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
         int index = ptpi->second;
         monoModulatedPatch.modulations[index] = value;
         monoModulatedPatch.update(index, patch);
+        paramVersions[index]++;
         auto val = monoModulatedPatch.values[index];
 
         auto ptl = paramToLag.find(id);
@@ -884,7 +1042,8 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
         case CLAP_EVENT_PARAM_VALUE:
         {
             auto v = reinterpret_cast<const clap_event_param_value *>(evt);
-            updateParamInPatch(v);
+            if (!paramRampCovers(v))
+                updateParamInPatch(v);
             return true;
         }
         case CLAP_EVENT_PARAM_MOD:
@@ -906,12 +1065,17 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
     void updateParamInPatch(const clap_event_param_value *v)
     {
         doValueUpdate(v->param_id, v->value);
+        sendParamValueToUI(v->param_id, v->value);
+    }
+
+    void sendParamValueToUI(clap_id id, double value)
+    {
         if (clapJuceShim && clapJuceShim->isEditorAttached())
         {
             auto r = ToUI();
             r.type = ToUI::PARAM_VALUE;
-            r.id = v->param_id;
-            r.value = (double)v->value;
+            r.id = id;
+            r.value = value;
 
             uiComms.toUiQ.push(r);
         }
@@ -976,6 +1140,22 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
     // Support for SST Biquads
     float note_to_pitch_ignoring_tuning(float n) const { return equalTuningTable.note_to_pitch(n); }
     float dbToLinear(float n) const { return dbToLinearTable.dbToLinear(n); }
+
+    /*
+     * Rate and pitch conversions go through the tables above rather than pow, which is
+     * several times slower and shows up in per block code. conduit-bench-conversions
+     * checks their error against pow over the ranges we use.
+     */
+    static constexpr double midiNoteZeroHz{8.17579891564};
+    float noteToFrequency(float note) const
+    {
+        return midiNoteZeroHz * note_to_pitch_ignoring_tuning(note);
+    }
+    // The per call step of a linear envelope which runs every blockLength samples
+    float envelopeRateLinear(float f, int blockLength, double srInv) const
+    {
+        return blockLength * srInv * twoToXTable.twoToThe(-f);
+    }
 };
 } // namespace sst::conduit::shared
 
@@ -0,0 +1,72 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_SRC_CONDUIT_SHARED_DERIVED_VALUE_H
+#define CONDUIT_SRC_CONDUIT_SHARED_DERIVED_VALUE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace sst::conduit::shared
+{
+/*
+ * Tracks the version counters of the N parameters some piece of derived state (a pan
+ * matrix, filter coefficients, an oscillator rate) is computed from. ClapBaseClass bumps
+ * a parameter's version whenever its value or modulation changes, so rather than
+ * recomputing every block you ask changed(), which is N integer compares.
+ *
+ * changed() is true on the first call after attach or invalidate, so the derived state
+ * always gets an initial computation. Attach with ClapBaseClass::attachDerived.
+ */
+template <size_t N> struct DerivedValue
+{
+    std::array<const uint32_t *, N> sources{};
+    std::array<uint32_t, N> seen{};
+    bool stale{true};
+
+    bool changed()
+    {
+        bool res = stale;
+        stale = false;
+        for (size_t i = 0; i < N; ++i)
+        {
+            if (sources[i] && *sources[i] != seen[i])
+            {
+                seen[i] = *sources[i];
+                res = true;
+            }
+        }
+        return res;
+    }
+
+    // For when something outside the parameters (sample rate, say) moves the result
+    void invalidate() { stale = true; }
+
+    template <typename F> void update(F &&recompute)
+    {
+        if (changed())
+            recompute();
+    }
+};
+} // namespace sst::conduit::shared
+
+#endif // CONDUIT_SRC_CONDUIT_SHARED_DERIVED_VALUE_H
@@ -0,0 +1,175 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_SRC_CONDUIT_SHARED_HUGE_PAGE_ARENA_H
+#define CONDUIT_SRC_CONDUIT_SHARED_HUGE_PAGE_ARENA_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace sst::conduit::shared
+{
+/*
+ * A runtime sized array of T which never reallocates behind your back, so pointers to
+ * elements are stable until the next allocate or reset, and which works for non-movable
+ * T. It is for the few buffers which are big enough (delay lines, the voice pool with its
+ * comb buffers) that ordinary 4k pages cost a TLB miss on almost every modulated or
+ * strided read.
+ *
+ * On linux the storage is an anonymous mapping aligned to 2MB and marked MADV_HUGEPAGE,
+ * so the kernel backs it with transparent huge pages where it can. allocate then writes
+ * one byte per page to fault the whole region in, which is the expensive part and is why
+ * allocate belongs on the main thread in activate, never in process. If the mapping or
+ * the advice fails, or on other platforms, we fall back to a cache line aligned operator
+ * new.
+ */
+template <typename T> struct HugePageArena
+{
+    static constexpr size_t hugePageSize{2 * 1024 * 1024};
+    static constexpr size_t smallPageSize{4096};
+    static constexpr size_t alignment{alignof(T) > 64 ? alignof(T) : 64};
+
+    HugePageArena() = default;
+    HugePageArena(const HugePageArena &) = delete;
+    HugePageArena &operator=(const HugePageArena &) = delete;
+    ~HugePageArena() { reset(); }
+
+    template <typename... Args> void allocate(size_t n, Args &&...args)
+    {
+        reset();
+        if (n == 0)
+            return;
+
+        bytes = n * sizeof(T);
+        void *mem = mapHugePages(bytes);
+        if (mem)
+        {
+            hugePages = true;
+            // A write per page faults the range in up front rather than on the audio thread
+            auto *p = static_cast<volatile char *>(mem);
+            for (size_t off = 0; off < mappedBytes; off += smallPageSize)
+                p[off] = 0;
+        }
+        else
+        {
+            hugePages = false;
+            mem = ::operator new(bytes, std::align_val_t(alignment));
+        }
+
+        data = static_cast<T *>(mem);
+        for (size_t i = 0; i < n; ++i)
+        {
+            new (data + i) T(args...);
+        }
+        count = n;
+    }
+
+    void reset()
+    {
+        if (!data)
+            return;
+
+        for (size_t i = count; i > 0; --i)
+        {
+            data[i - 1].~T();
+        }
+#if defined(__linux__)
+        if (hugePages)
+            munmap(data, mappedBytes);
+        else
+#endif
+            ::operator delete(data, std::align_val_t(alignment));
+        data = nullptr;
+        count = 0;
+        bytes = 0;
+        mappedBytes = 0;
+        hugePages = false;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    // True if the kernel accepted the huge page advice; it may still split pages later
+    bool isHugePageBacked() const { return hugePages; }
+
+    T &operator[](size_t i)
+    {
+        assert(i < count);
+        return data[i];
+    }
+    const T &operator[](size_t i) const
+    {
+        assert(i < count);
+        return data[i];
+    }
+
+    T *begin() { return data; }
+    T *end() { return data + count; }
+    const T *begin() const { return data; }
+    const T *end() const { return data + count; }
+
+  private:
+    void *mapHugePages(size_t sz)
+    {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        mappedBytes = (sz + hugePageSize - 1) & ~(hugePageSize - 1);
+
+        // mmap only promises small page alignment, so map a huge page extra and trim
+        auto span = mappedBytes + hugePageSize;
+        auto raw = mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED)
+            return nullptr;
+
+        auto base = reinterpret_cast<uintptr_t>(raw);
+        auto aligned = (base + hugePageSize - 1) & ~(uintptr_t)(hugePageSize - 1);
+        auto head = aligned - base;
+        auto tail = span - head - mappedBytes;
+        if (head)
+            munmap(raw, head);
+        if (tail)
+            munmap(reinterpret_cast<void *>(aligned + mappedBytes), tail);
+
+        auto *mem = reinterpret_cast<void *>(aligned);
+        if (madvise(mem, mappedBytes, MADV_HUGEPAGE) != 0)
+        {
+            munmap(mem, mappedBytes);
+            return nullptr;
+        }
+        return mem;
+#else
+        return nullptr;
+#endif
+    }
+
+    T *data{nullptr};
+    size_t count{0}, bytes{0}, mappedBytes{0};
+    bool hugePages{false};
+};
+} // namespace sst::conduit::shared
+
+#endif // CONDUIT_SRC_CONDUIT_SHARED_HUGE_PAGE_ARENA_H
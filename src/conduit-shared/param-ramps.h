@@ -0,0 +1,171 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_SRC_CONDUIT_SHARED_PARAM_RAMPS_H
+#define CONDUIT_SRC_CONDUIT_SHARED_PARAM_RAMPS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <clap/clap.h>
+
+namespace sst::conduit::shared
+{
+/*
+ * Dense host automation arrives as many CLAP_EVENT_PARAM_VALUE events per buffer. A
+ * plugin which processes in blocks only sees the value current at each block start,
+ * so the automation shape gets quantized to the block.
+ *
+ * At the top of process this stage scans the inbound events once and folds each pair of
+ * consecutive value events for the same parameter, no more than maxSpan samples apart,
+ * into a linear ramp segment. At each block boundary the plugin asks for the value of
+ * every ramping parameter at the end of the block and pushes it through the usual value
+ * update, so the lipols and lags which already interpolate across the block follow the
+ * host's shape at block rate.
+ *
+ * The ramps carry the values of the events they were built from, so the plugin drops
+ * those events (see covers) rather than applying them at their own times, which would
+ * pull the value back behind the block end value just applied. Isolated events and
+ * stepped parameters are never ramped and apply as before. Storage is fixed; if a buffer
+ * has more segments than maxSegments the rest just apply as steps.
+ */
+template <size_t nParams, size_t maxSegments = 1024> struct ParamRampStage
+{
+    static constexpr uint32_t maxSpan{512};
+
+    struct Segment
+    {
+        clap_id id;
+        uint32_t t0, t1;
+        float v0, v1;
+        bool endsRun; // false if the next segment of this param picks up at t1
+    };
+
+    // Set once from the param descriptions; stepped params are excluded
+    std::array<bool, nParams> rampable{};
+
+    /*
+     * indexFor maps a clap_id to a patch index or -1, which lets us avoid depending on
+     * the base class maps here.
+     */
+    template <typename IndexFor> void scan(const clap_input_events *in, IndexFor &&indexFor)
+    {
+        nSegments = 0;
+        cursor = 0;
+        lastTime.fill(noEvent);
+        lastSegment.fill(-1);
+
+        auto sz = in->size(in);
+        for (uint32_t e = 0; e < sz; ++e)
+        {
+            auto evt = in->get(in, e);
+            if (evt->space_id != CLAP_CORE_EVENT_SPACE_ID || evt->type != CLAP_EVENT_PARAM_VALUE)
+                continue;
+
+            auto v = reinterpret_cast<const clap_event_param_value *>(evt);
+            int idx = indexFor(v->param_id);
+            if (idx < 0 || !rampable[idx])
+                continue;
+
+            auto t = evt->time;
+            if (lastTime[idx] != noEvent && t - lastTime[idx] <= maxSpan && t > lastTime[idx] &&
+                nSegments < maxSegments)
+            {
+                if (lastSegment[idx] >= 0 && segments[lastSegment[idx]].t1 == lastTime[idx])
+                    segments[lastSegment[idx]].endsRun = false;
+
+                lastSegment[idx] = (int32_t)nSegments;
+                segments[nSegments++] = {v->param_id, lastTime[idx], t, lastValue[idx],
+                                         (float)v->value, true};
+            }
+            lastTime[idx] = t;
+            lastValue[idx] = (float)v->value;
+        }
+    }
+
+    bool empty() const { return cursor >= nSegments; }
+
+    // Forget the last scan, for event lists which are never scanned such as paramsFlush
+    void clear()
+    {
+        nSegments = 0;
+        cursor = 0;
+    }
+
+    /*
+     * True if a value event for id at time is an end of one of this scan's segments, in
+     * which case advance applies it and the plugin should drop the event.
+     */
+    bool covers(clap_id id, uint32_t time) const
+    {
+        for (auto k = cursor; k < nSegments; ++k)
+        {
+            const auto &s = segments[k];
+            // t0 >= t1 - maxSpan, so nothing past here can start by time
+            if (s.t1 > time + maxSpan)
+                break;
+            if (s.id == id && s.t0 <= time && time <= s.t1)
+                return true;
+        }
+        return false;
+    }
+
+    /*
+     * Call at a block boundary with the block covering [blockStart, blockEnd) in buffer
+     * time. apply(id, value) is called with the ramp value at blockEnd for each parameter
+     * whose ramp overlaps the block, either from the segment spanning blockEnd or as the
+     * final value of a run which ends inside the block.
+     */
+    template <typename Apply> void advance(uint32_t blockStart, uint32_t blockEnd, Apply &&apply)
+    {
+        // Segments are ordered by end time since the event list is time ordered
+        while (cursor < nSegments && segments[cursor].t1 < blockStart)
+            cursor++;
+
+        for (auto k = cursor; k < nSegments; ++k)
+        {
+            const auto &s = segments[k];
+            // t0 >= t1 - maxSpan, so nothing past here can start before blockEnd
+            if (s.t1 > blockEnd + maxSpan)
+                break;
+            if (s.t0 > blockEnd)
+                continue;
+
+            if (blockEnd < s.t1)
+                apply(s.id, s.v0 + (s.v1 - s.v0) * (blockEnd - s.t0) / (float)(s.t1 - s.t0));
+            else if (s.endsRun)
+                apply(s.id, s.v1);
+        }
+    }
+
+  private:
+    static constexpr uint32_t noEvent{0xFFFFFFFF};
+
+    std::array<Segment, maxSegments> segments{};
+    size_t nSegments{0}, cursor{0};
+    std::array<uint32_t, nParams> lastTime{};
+    std::array<float, nParams> lastValue{};
+    std::array<int32_t, nParams> lastSegment{};
+};
+} // namespace sst::conduit::shared
+
+#endif // CONDUIT_SRC_CONDUIT_SHARED_PARAM_RAMPS_H
@@ -0,0 +1,96 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_SRC_CONDUIT_SHARED_PARAM_TEXT_CACHE_H
+#define CONDUIT_SRC_CONDUIT_SHARED_PARAM_TEXT_CACHE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace sst::conduit::shared
+{
+/*
+ * A tiny least recently used cache of formatted strings for one parameter. Hosts drawing
+ * automation lanes ask for the text of the same handful of values over and over, so a
+ * few entries per parameter catch almost all of it. Keys are whatever the caller
+ * quantizes the value to; ClapBaseClass folds the temposync state into the key too.
+ *
+ * Main thread only. Entries keep their string buffers when evicted, so a warm cache
+ * formats into existing storage rather than allocating.
+ */
+template <size_t nEntries = 8> struct ParamTextCache
+{
+    // Returns nullptr on a miss
+    const std::string *find(int64_t key)
+    {
+        for (auto &e : entries)
+        {
+            if (e.valid && e.key == key)
+            {
+                e.lastUse = ++clock;
+                return &e.text;
+            }
+        }
+        return nullptr;
+    }
+
+    const std::string &insert(int64_t key, const std::string &text)
+    {
+        auto *victim = &entries[0];
+        for (auto &e : entries)
+        {
+            if (!e.valid)
+            {
+                victim = &e;
+                break;
+            }
+            if (e.lastUse < victim->lastUse)
+                victim = &e;
+        }
+        victim->key = key;
+        victim->text.assign(text);
+        victim->valid = true;
+        victim->lastUse = ++clock;
+        return victim->text;
+    }
+
+    void clear()
+    {
+        for (auto &e : entries)
+            e.valid = false;
+    }
+
+  private:
+    struct Entry
+    {
+        int64_t key{0};
+        uint32_t lastUse{0};
+        bool valid{false};
+        std::string text;
+    };
+    std::array<Entry, nEntries> entries{};
+    uint32_t clock{0};
+};
+} // namespace sst::conduit::shared
+
+#endif // CONDUIT_SRC_CONDUIT_SHARED_PARAM_TEXT_CACHE_H
@@ -0,0 +1,126 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_SRC_CONDUIT_SHARED_SNAPSHOT_POOL_H
+#define CONDUIT_SRC_CONDUIT_SHARED_SNAPSHOT_POOL_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace sst::conduit::shared
+{
+// Kept outside the pool so pointers to it can be declared while T is still incomplete
+template <typename T> struct Snapshot
+{
+    T value{};
+    uint64_t version{0};
+};
+
+/*
+ * A fixed pool of immutable, versioned snapshots of T, shared read copy update style
+ * between any number of writers and the audio thread.
+ *
+ * A writer acquires a free slot, fills it in, and publishes it into an atomic pointer.
+ * The snapshot it replaces is retired, stamped with the reader epoch at that moment.
+ * The audio thread brackets each process call in a ReadSection, which bumps the epoch
+ * on the way in and out, so the epoch is odd exactly while a reader may be holding a
+ * pointer it loaded earlier. A retired slot is safe to reuse once the epoch has moved
+ * past its stamp (or if the stamp was even), and reclaim does that on the main thread.
+ *
+ * Nothing here allocates after construction, so acquire and publish are safe on the
+ * audio thread. If the pool is exhausted acquire returns nullptr and the writer should
+ * retry later. Since slots are reused, readers which cache anything derived from a
+ * snapshot should compare versions, not pointers.
+ */
+template <typename T, size_t poolSize> struct SnapshotPool
+{
+    using snapshot_t = Snapshot<T>;
+
+    snapshot_t *acquire()
+    {
+        for (size_t i = 0; i < poolSize; ++i)
+        {
+            auto expected = FREE;
+            if (state[i].compare_exchange_strong(expected, ACQUIRED))
+                return &slots[i];
+        }
+        return nullptr;
+    }
+
+    void publish(std::atomic<const snapshot_t *> &to, snapshot_t *s)
+    {
+        s->version = nextVersion.fetch_add(1) + 1;
+        auto old = to.exchange(s);
+        if (old)
+        {
+            auto idx = old - slots.data();
+            retiredAt[idx] = epoch.load();
+            state[idx].store(RETIRED, std::memory_order_release);
+        }
+    }
+
+    // Main thread only. Returns true if retired slots are still waiting on a reader.
+    bool reclaim()
+    {
+        auto now = epoch.load();
+        bool pending{false};
+        for (size_t i = 0; i < poolSize; ++i)
+        {
+            if (state[i].load(std::memory_order_acquire) != RETIRED)
+                continue;
+
+            if ((retiredAt[i] & 1) == 0 || now > retiredAt[i])
+                state[i].store(FREE, std::memory_order_release);
+            else
+                pending = true;
+        }
+        return pending;
+    }
+
+    struct ReadSection
+    {
+        explicit ReadSection(SnapshotPool &p) : pool(p) { pool.epoch.fetch_add(1); }
+        ~ReadSection() { pool.epoch.fetch_add(1); }
+        ReadSection(const ReadSection &) = delete;
+        ReadSection &operator=(const ReadSection &) = delete;
+
+      private:
+        SnapshotPool &pool;
+    };
+
+  private:
+    enum SlotState : uint8_t
+    {
+        FREE,
+        ACQUIRED,
+        RETIRED
+    };
+
+    std::array<snapshot_t, poolSize> slots{};
+    std::array<std::atomic<SlotState>, poolSize> state{};
+    std::array<uint64_t, poolSize> retiredAt{};
+    std::atomic<uint64_t> epoch{0}, nextVersion{0};
+};
+} // namespace sst::conduit::shared
+
+#endif // CONDUIT_SRC_CONDUIT_SHARED_SNAPSHOT_POOL_H
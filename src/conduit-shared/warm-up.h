@@ -0,0 +1,47 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_SRC_CONDUIT_SHARED_WARM_UP_H
+#define CONDUIT_SRC_CONDUIT_SHARED_WARM_UP_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sst::conduit::shared
+{
+/*
+ * Reads and writes back one byte on every small page of a buffer, so the whole range is
+ * faulted in and mapped writable without changing its contents.
+ */
+inline void touchPages(const void *p, size_t bytes)
+{
+    static constexpr size_t pageSize{4096};
+    if (!p || bytes == 0)
+        return;
+
+    auto *c = static_cast<volatile char *>(const_cast<void *>(p));
+    for (size_t off = 0; off < bytes; off += pageSize)
+        c[off] = c[off];
+    c[bytes - 1] = c[bytes - 1];
+}
+} // namespace sst::conduit::shared
+
+#endif // CONDUIT_SRC_CONDUIT_SHARED_WARM_UP_H
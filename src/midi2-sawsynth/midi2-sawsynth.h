@@ -44,6 +44,7 @@ struct ConduitMIDI2SawSynthConfig
     static constexpr int nParams{sst::conduit::midi2_sawsynth::nParams};
     static constexpr bool baseClassProvidesMonoModSupport{true};
     static constexpr bool usesSpecializedMessages{false};
+    static constexpr bool primeOnActivate{false};
     using PatchExtension = sst::conduit::shared::EmptyPatchExtension;
     struct DataCopyForUI
     {
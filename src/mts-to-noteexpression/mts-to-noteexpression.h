@@ -45,6 +45,7 @@ struct ConduitMTSToNoteExpressionConfig
     static constexpr int nParams{sst::conduit::mts_to_noteexpression::nParams};
     static constexpr bool baseClassProvidesMonoModSupport{true};
     static constexpr bool usesSpecializedMessages{false};
+    static constexpr bool primeOnActivate{false};
     using PatchExtension = sst::conduit::shared::EmptyPatchExtension;
     struct DataCopyForUI
     {
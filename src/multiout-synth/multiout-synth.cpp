@@ -22,6 +22,7 @@
 #include "multiout-synth.h"
 #include "juce_gui_basics/juce_gui_basics.h"
 #include "version.h"
+#include "conduit-shared/audio-port-io.h"
 
 #include "sst/cpputils/constructors.h"
 #include "sst/cpputils/iterators.h"
@@ -91,6 +92,7 @@ ConduitMultiOutSynth::ConduitMultiOutSynth(const clap_host *host)
         attachParam(pmFreq0 + i, chans[i].freq);
         attachParam(pmTime0 + i, chans[i].time);
         attachParam(pmMute0 + i, chans[i].mute);
+        attachDerived(chans[i].rateInputs, {pmFreq0 + i});
     }
 
     clapJuceShim = std::make_unique<sst::clap_juce_shim::ClapJuceShim>(this);
@@ -114,7 +116,9 @@ bool ConduitMultiOutSynth::audioPortsInfo(uint32_t index, bool isInput,
         else
         {
             snprintf(info->name, sizeof(info->name) - 1, "aux output %d", index);
+            info->flags = 0;
         }
+        info->flags |= CLAP_AUDIO_PORT_SUPPORTS_64BITS;
         info->channel_count = 2;
         info->port_type = CLAP_PORT_STEREO;
 
@@ -146,6 +150,10 @@ clap_process_status ConduitMultiOutSynth::process(const clap_process *process) n
         nextEvent = ev->get(ev, nextEventIndex);
     }
 
+    // Rendered a block at a time into floats, then converted to the port format in one go
+    float rendered alignas(16)[nOuts][blockSize];
+    uint32_t spanStart{0};
+
     for (auto s = 0U; s < process->frames_count; ++s)
     {
         while (nextEvent && nextEvent->time == s)
@@ -158,8 +166,9 @@ clap_process_status ConduitMultiOutSynth::process(const clap_process *process) n
                 nextEvent = ev->get(ev, nextEventIndex);
         }
 
-        for (auto &c : chans)
+        for (auto ci = 0; ci < nOuts; ++ci)
         {
+            auto &c = chans[ci];
             c.env.process(0.0, 0.1, 0.1, 0.1, 0, 0, 0, true);
             c.timeSinceTrigger += sampleRateInv;
             if (c.timeSinceTrigger > *(c.time))
@@ -167,13 +176,24 @@ clap_process_status ConduitMultiOutSynth::process(const clap_process *process) n
                 c.timeSinceTrigger -= *(c.time);
                 c.env.attackFrom(0, 0.1, 0, true);
 
-                c.osc.setRate(2.0 * M_PI * 440.0 * pow(2.f, (*(c.freq) - 69) / 12) *
-                              dsamplerate_inv);
+                if (c.rateInputs.changed())
+                    c.rate = 2.0 * M_PI * noteToFrequency(*(c.freq)) * dsamplerate_inv;
+                c.osc.setRate(c.rate);
             }
-            auto v = c.env.output * c.osc.u;
+            rendered[ci][s - spanStart] = c.env.output * c.osc.u;
             c.osc.step();
-            process->audio_outputs[c.chan].data32[0][s] = v;
-            process->audio_outputs[c.chan].data32[1][s] = v;
+        }
+
+        auto n = s + 1 - spanStart;
+        if (n == blockSize || s + 1 == process->frames_count)
+        {
+            for (auto ci = 0; ci < nOuts; ++ci)
+            {
+                const auto &port = process->audio_outputs[chans[ci].chan];
+                shared::storeSpan(port, 0, spanStart, rendered[ci], n);
+                shared::storeSpan(port, 1, spanStart, rendered[ci], n);
+            }
+            spanStart = s + 1;
         }
     }
 
@@ -43,6 +43,7 @@ struct ConduitMultiOutSynthConfig
     static constexpr int nParams{sst::conduit::multiout_synth::nParams};
     static constexpr bool baseClassProvidesMonoModSupport{true};
     static constexpr bool usesSpecializedMessages{false};
+    static constexpr bool primeOnActivate{false};
     using PatchExtension = sst::conduit::shared::EmptyPatchExtension;
     struct DataCopyForUI
     {
@@ -64,6 +65,8 @@ struct ConduitMultiOutSynth
                   uint32_t maxFrameCount) noexcept override
     {
         setSampleRate(sampleRate);
+        for (auto &c : chans)
+            c.rateInputs.invalidate();
         return true;
     }
 
@@ -126,13 +129,17 @@ struct ConduitMultiOutSynth
         float *freq;
         float *time;
         float *mute;
+
+        // The oscillator rate for freq, recomputed only when freq changes
+        sst::conduit::shared::DerivedValue<1> rateInputs;
+        double rate{0};
     };
     std::array<Chan, nOuts> chans;
 
   public:
     inline float envelope_rate_linear_nowrap(float f)
     {
-        return blockSize * sampleRateInv * pow(2.f, -f);
+        return envelopeRateLinear(f, blockSize, sampleRateInv);
     }
 
   public:
@@ -21,6 +21,7 @@
 
 #include "polymetric-delay.h"
 #include "version.h"
+#include "conduit-shared/audio-port-io.h"
 #include "sst/basic-blocks/dsp/PanLaws.h"
 
 namespace sst::conduit::polymetric_delay
@@ -169,6 +170,8 @@ ConduitPolymetricDelay::ConduitPolymetricDelay(const clap_host *host)
 
         attachParam(pmTapLowCut + i, tapData[i].locut);
         attachParam(pmTapHighCut + i, tapData[i].hicut);
+        attachDerived(tapData[i].panInputs, {pmTapOutputPan + i});
+        attachDerived(tapData[i].filterInputs, {pmTapLowCut + i, pmTapHighCut + i});
 
         attachParam(pmDelayModDepth + i, tapData[i].moddepth);
         attachParam(pmDelayModRate + i, tapData[i].modrate);
@@ -193,9 +196,9 @@ bool ConduitPolymetricDelay::audioPortsInfo(uint32_t index, bool isInput,
     if (isInput)
     {
         info->id = inId;
-        info->in_place_pair = CLAP_INVALID_ID;
+        info->in_place_pair = outId;
         strncpy(info->name, "main input", sizeof(info->name));
-        info->flags = CLAP_AUDIO_PORT_IS_MAIN;
+        info->flags = CLAP_AUDIO_PORT_IS_MAIN | CLAP_AUDIO_PORT_SUPPORTS_64BITS;
         info->channel_count = 2;
         info->port_type = CLAP_PORT_STEREO;
 
@@ -204,9 +207,9 @@ bool ConduitPolymetricDelay::audioPortsInfo(uint32_t index, bool isInput,
     else
     {
         info->id = outId;
-        info->in_place_pair = CLAP_INVALID_ID;
+        info->in_place_pair = inId;
         strncpy(info->name, "main output", sizeof(info->name));
-        info->flags = CLAP_AUDIO_PORT_IS_MAIN;
+        info->flags = CLAP_AUDIO_PORT_IS_MAIN | CLAP_AUDIO_PORT_SUPPORTS_64BITS;
         info->channel_count = 2;
         info->port_type = CLAP_PORT_STEREO;
 
@@ -234,10 +237,11 @@ clap_process_status ConduitPolymetricDelay::process(const clap_process *process)
     if (process->audio_inputs_count <= 0)
         return CLAP_PROCESS_SLEEP;
 
-    float **out = process->audio_outputs[0].data32;
+    // Either port may arrive as 32 or 64 bit; loadSpan and storeSpan convert each span
+    const auto &out = process->audio_outputs[0];
     auto ochans = process->audio_outputs->channel_count;
 
-    float **const in = process->audio_inputs[0].data32;
+    const auto &in = process->audio_inputs[0];
     auto ichans = process->audio_inputs->channel_count;
 
     auto chans = std::min(ochans, ichans);
@@ -254,20 +258,27 @@ clap_process_status ConduitPolymetricDelay::process(const clap_process *process)
     {
         nextEvent = ev->get(ev, nextEventIndex);
     }
+    scanParamRamps(ev);
 
     if (process->transport)
     {
         handleInboundEvent((const clap_event_header *)(process->transport));
     }
+    else
+    {
+        // without a transport we hold the last tempo rather than ramp on forever
+        tempoChanged(tempoAt(samplesProcessed), 0, samplesProcessed);
+    }
 
-    float inMx[2]{0, 0}, outMx[2]{0, 0}, tapMx[nTaps][2]{};
-    bool active[nTaps];
     for (int i = 0; i < nTaps; ++i)
     {
-        active[i] = *(tapData[i].active) > 0.5;
+        span.active[i] = *(tapData[i].active) > 0.5;
     }
+    memset(span.inMx, 0, sizeof(span.inMx));
+    memset(span.outMx, 0, sizeof(span.outMx));
+    memset(span.tapMx, 0, sizeof(span.tapMx));
 
-    for (auto i = 0U; i < process->frames_count; ++i)
+    for (auto i = 0U; i < process->frames_count;)
     {
         while (nextEvent && nextEvent->time == i)
         {
@@ -282,94 +293,236 @@ clap_process_status ConduitPolymetricDelay::process(const clap_process *process)
         if (slowProcess >= blockSize)
         {
             slowProcess = 0;
-            inVU.process(inMx[0], inMx[1]);
-            outVU.process(outMx[0], outMx[1]);
-            inMx[0] = 0;
-            inMx[1] = 0;
-            outMx[0] = 0;
-            outMx[1] = 0;
+            applyParamRamps(i, i + blockSize,
+                            [this](clap_id id, float v) { specificParamChange(id, v); });
+
+            inVU.process(span.inMx[0], span.inMx[1]);
+            outVU.process(span.outMx[0], span.outMx[1]);
+            span.inMx[0] = 0;
+            span.inMx[1] = 0;
+            span.outMx[0] = 0;
+            span.outMx[1] = 0;
 
             for (int t = 0; t < nTaps; ++t)
             {
-                tapOutVU[t].process(tapMx[t][0], tapMx[t][1]);
+                tapOutVU[t].process(span.tapMx[t][0], span.tapMx[t][1]);
+
+                span.tapMx[t][0] = 0;
+                span.tapMx[t][1] = 0;
+
+                auto &td = tapData[t];
+                if (td.panInputs.changed())
+                {
+                    sst::basic_blocks::dsp::pan_laws::stereoEqualPower((*(td.pan) + 1) * 0.5,
+                                                                       tapPanMatrix[t]);
+                }
+
+                // The biquads interpolate their coefficients across a block from the last
+                // set, so after a change set them once more to let the ramp land
+                if (td.filterInputs.changed())
+                    td.filterRefreshBlocks = 2;
+                if (td.filterRefreshBlocks > 0)
+                {
+                    setTapFilterFrequencies(t);
+                    td.filterRefreshBlocks--;
+                }
+            }
+        }
 
-                tapMx[t][0] = 0;
-                tapMx[t][1] = 0;
+        auto spanEnd = std::min(process->frames_count, i + blockSize - slowProcess);
+        if (nextEvent && nextEvent->time > i && nextEvent->time < spanEnd)
+            spanEnd = nextEvent->time;
+        auto n = spanEnd - i;
 
-                // Recalc pan laws
-                sst::basic_blocks::dsp::pan_laws::stereoEqualPower((*(tapData[t].pan) + 1) * 0.5,
-                                                                   tapPanMatrix[t]);
+        // in and out may be the same buffer, so the whole span is taken before any output
+        for (int c = 0; c < 2; ++c)
+            shared::loadSpan(in, c, i, span.in[c], n);
 
-                setTapFilterFrequencies(t);
+        beginSpan(n);
+        rampTaps(i, n);
+        if (spanReadsOnlyHistory(n))
+        {
+            processTaps(0, n, true);
+            writeSpan(0, n);
+        }
+        else
+        {
+            for (auto k = 0U; k < n; ++k)
+            {
+                processTaps(k, k + 1, false);
+                writeSpan(k, k + 1);
             }
         }
-        slowProcess++;
 
-        float totalTapOut[2]{};
-        float totalTapFB[2]{};
+        for (int c = 0; c < 2; ++c)
+            shared::storeSpan(out, c, i, span.out[c], n);
+
         for (int tap = 0; tap < nTaps; ++tap)
-        {
-            if (!active[tap])
-                continue;
+            baseTapSamples[tap] += tapSamplesInc[tap] * n;
 
-            auto tl = tapData[tap].level.v;
-            tl = tl * tl * tl;
-            auto ftl = tapData[tap].fblev.v;
-            ftl = ftl * ftl * ftl;
-            auto cftl = tapData[tap].crossfblev.v;
-            cftl = cftl * cftl * cftl;
+        slowProcess += n;
+        i = spanEnd;
+    }
+    samplesProcessed += process->frames_count;
 
-            tapData[tap].modulator.step();
-            auto tt = baseTapSamples[tap] *
-                      (1 + modDepthScale * tapData[tap].moddepth.v * tapData[tap].modulator.u);
+    for (int c = 0; c < 2; ++c)
+    {
+        uiComms.dataCopyForUI.inVu[c] = inVU.vu_peak[c];
+        uiComms.dataCopyForUI.outVu[c] = outVU.vu_peak[c];
+        for (int t = 0; t < nTaps; ++t)
+        {
+            uiComms.dataCopyForUI.tapVu[t][c] = tapOutVU[t].vu_peak[c];
+        }
+    }
 
-            auto smpL = delayLine[0].read(tt);
-            auto smpR = delayLine[1].read(tt);
+    return CLAP_PROCESS_CONTINUE;
+}
 
-            auto dL = smpL * tapPanMatrix[tap][0] + smpR * tapPanMatrix[tap][2];
-            auto dR = smpR * tapPanMatrix[tap][1] + smpL * tapPanMatrix[tap][3];
+void ConduitPolymetricDelay::beginSpan(uint32_t n)
+{
+    for (auto k = 0U; k < n; ++k)
+    {
+        for (int tap = 0; tap < nTaps; ++tap)
+        {
+            auto &td = tapData[tap];
+            span.level[tap][k] = td.level.v * td.level.v * td.level.v;
+            span.fblev[tap][k] = td.fblev.v * td.fblev.v * td.fblev.v;
+            span.crossfblev[tap][k] = td.crossfblev.v * td.crossfblev.v * td.crossfblev.v;
+            span.moddepth[tap][k] = td.moddepth.v;
+        }
+        processLags();
+    }
 
-            dL = dL * tl;
-            dR = dR * tl;
+    memset(span.tapOut, 0, sizeof(span.tapOut));
+    memset(span.tapFB, 0, sizeof(span.tapFB));
+}
 
-            hp[tap].process_sample(dL, dR, dL, dR);
-            lp[tap].process_sample(dL, dR, dL, dR);
+/*
+ * Runs the tap loop, both the block and the sample at a time paths, over a block at zero
+ * level, so the sinc reads, the biquads and the tap code are warm for the first process.
+ * The delay line isn't written, and the modulators and the span are put back after.
+ */
+void ConduitPolymetricDelay::primeKernels()
+{
+    std::array<decltype(TapData::modulator), nTaps> modulators;
+    for (int t = 0; t < nTaps; ++t)
+        modulators[t] = tapData[t].modulator;
+
+    memset(&span, 0, sizeof(span));
+    for (auto &a : span.active)
+        a = true;
+    processTaps(0, blockSize, true);
+    processTaps(0, 1, false);
+    memset(&span, 0, sizeof(span));
+
+    for (int t = 0; t < nTaps; ++t)
+        tapData[t].modulator = modulators[t];
+}
 
-            tapMx[tap][0] = std::max(tapMx[tap][0], std::abs(dL));
-            tapMx[tap][1] = std::max(tapMx[tap][1], std::abs(dR));
+bool ConduitPolymetricDelay::spanReadsOnlyHistory(uint32_t n) const
+{
+    for (int tap = 0; tap < nTaps; ++tap)
+    {
+        if (!span.active[tap])
+            continue;
+
+        float depth{0.f};
+        for (auto k = 0U; k < n; ++k)
+            depth = std::max(depth, std::abs(span.moddepth[tap][k]));
+
+        // the modulator stays within +/- 1, and a ramping tap is shortest at one end
+        auto base = std::min(baseTapSamples[tap], baseTapSamples[tap] + tapSamplesInc[tap] * n);
+        auto shortest = base * (1 - modDepthScale * depth);
+        if (shortest < n + spanHistoryGuard)
+            return false;
+    }
+    return true;
+}
 
-            totalTapOut[0] += dL;
-            totalTapOut[1] += dR;
+/*
+ * Reads, pans, filters and meters each active tap for samples [from, to) of the span,
+ * accumulating into span.tapOut and span.tapFB. With writesDeferred the delay line write
+ * pointer is still at the span start, so sample k reads k samples closer to it.
+ */
+void ConduitPolymetricDelay::processTaps(uint32_t from, uint32_t to, bool writesDeferred)
+{
+    float smpL alignas(16)[blockSize], smpR alignas(16)[blockSize];
+    float dL alignas(16)[blockSize], dR alignas(16)[blockSize];
 
-            totalTapFB[0] += smpL * ftl + smpR * cftl;
-            totalTapFB[1] += smpR * ftl + smpL * cftl;
+    for (int tap = 0; tap < nTaps; ++tap)
+    {
+        if (!span.active[tap])
+            continue;
+
+        auto &td = tapData[tap];
+        for (auto k = from; k < to; ++k)
+        {
+            td.modulator.step();
+            auto tt = (baseTapSamples[tap] + tapSamplesInc[tap] * k) *
+                      (1 + modDepthScale * span.moddepth[tap][k] * td.modulator.u);
+            if (writesDeferred)
+                tt -= k;
+
+            smpL[k] = delayLine[0].read(tt);
+            smpR[k] = delayLine[1].read(tt);
         }
 
-        auto dl = (*dryLev);
-        dl = dl * dl * dl;
-        for (auto c = 0U; c < chans; ++c)
+        const auto *pm = tapPanMatrix[tap];
+        const auto *tl = span.level[tap];
+        for (auto k = from; k < to; ++k)
         {
-            out[c][i] = in[c][i] * dl + totalTapOut[c];
+            dL[k] = (smpL[k] * pm[0] + smpR[k] * pm[2]) * tl[k];
+            dR[k] = (smpR[k] * pm[1] + smpL[k] * pm[3]) * tl[k];
+        }
 
-            delayLine[c].write(in[c][i] + totalTapFB[c]);
-            inMx[c] = std::max(inMx[c], std::abs(in[c][i]));
-            outMx[c] = std::max(outMx[c], std::abs(out[c][i]));
+        if (to - from == blockSize)
+        {
+            hp[tap].process_block(dL, dR);
+            lp[tap].process_block(dL, dR);
+        }
+        else
+        {
+            for (auto k = from; k < to; ++k)
+            {
+                hp[tap].process_sample(dL[k], dR[k], dL[k], dR[k]);
+                lp[tap].process_sample(dL[k], dR[k], dL[k], dR[k]);
+            }
         }
 
-        processLags();
+        const auto *ftl = span.fblev[tap];
+        const auto *cftl = span.crossfblev[tap];
+        auto &mx = span.tapMx[tap];
+        for (auto k = from; k < to; ++k)
+        {
+            mx[0] = std::max(mx[0], std::abs(dL[k]));
+            mx[1] = std::max(mx[1], std::abs(dR[k]));
+
+            span.tapOut[0][k] += dL[k];
+            span.tapOut[1][k] += dR[k];
+
+            span.tapFB[0][k] += smpL[k] * ftl[k] + smpR[k] * cftl[k];
+            span.tapFB[1][k] += smpR[k] * ftl[k] + smpL[k] * cftl[k];
+        }
     }
+}
 
-    for (int c = 0; c < 2; ++c)
+void ConduitPolymetricDelay::writeSpan(uint32_t from, uint32_t to)
+{
+    auto dl = (*dryLev);
+    dl = dl * dl * dl;
+    for (auto k = from; k < to; ++k)
     {
-        uiComms.dataCopyForUI.inVu[c] = inVU.vu_peak[c];
-        uiComms.dataCopyForUI.outVu[c] = outVU.vu_peak[c];
-        for (int t = 0; t < nTaps; ++t)
+        for (int c = 0; c < 2; ++c)
         {
-            uiComms.dataCopyForUI.tapVu[t][c] = tapOutVU[t].vu_peak[c];
+            auto x = span.in[c][k];
+            auto y = x * dl + span.tapOut[c][k];
+
+            delayLine[c].write(x + span.tapFB[c][k]);
+            span.inMx[c] = std::max(span.inMx[c], std::abs(x));
+            span.outMx[c] = std::max(span.outMx[c], std::abs(y));
+            span.out[c][k] = y;
         }
     }
-
-    return CLAP_PROCESS_CONTINUE;
 }
 
 void ConduitPolymetricDelay::handleInboundEvent(const clap_event_header_t *evt)
@@ -383,6 +536,8 @@ void ConduitPolymetricDelay::handleInboundEvent(const clap_event_header_t *evt)
     case CLAP_EVENT_PARAM_VALUE:
     {
         auto v = reinterpret_cast<const clap_event_param_value *>(evt);
+        if (paramRampCovers(v))
+            break;
         updateParamInPatch(v);
         specificParamChange(v->param_id, v->value);
     }
@@ -399,12 +554,8 @@ void ConduitPolymetricDelay::handleInboundEvent(const clap_event_header_t *evt)
     case CLAP_EVENT_TRANSPORT:
     {
         auto tev = reinterpret_cast<const clap_event_transport_t *>(evt);
-        auto ptempo = tempo;
-        tempo = tev->tempo;
-        if (ptempo != tempo)
-        {
-            recalcTaps();
-        }
+        if (tev->flags & CLAP_TRANSPORT_HAS_TEMPO)
+            tempoChanged(tev->tempo, tev->tempo_inc, samplesProcessed + evt->time);
 
         uiComms.dataCopyForUI.tempo = tev->tempo;
         uiComms.dataCopyForUI.bar_start = tev->bar_start;
@@ -433,6 +584,42 @@ void ConduitPolymetricDelay::specificParamChange(clap_id id, float val)
     }
 }
 
+double ConduitPolymetricDelay::tempoAt(uint64_t t) const
+{
+    auto res = tempo + tempoInc * ((double)t - (double)tempoTime);
+    return std::clamp(res, 1.0, 999.0);
+}
+
+void ConduitPolymetricDelay::tempoChanged(double newTempo, double newTempoInc, uint64_t at)
+{
+    auto expected = tempoAt(at);
+    tempo = std::clamp(newTempo, 1.0, 999.0);
+    tempoInc = newTempoInc;
+    tempoTime = at;
+
+    // Hosts which step the tempo per buffer rather than send tempo_inc land near the ramp
+    // and get ramped too. Anything further off is a jump, and gliding the taps across
+    // that much of the line would sound worse than the click.
+    if (std::abs(tempo - expected) > tempoJumpTolerance * expected)
+        recalcTaps();
+}
+
+/*
+ * One setup per span: each tap heads for its length at the tempo at the span end, in
+ * equal steps. The process loop moves baseTapSamples along once the span is done.
+ */
+void ConduitPolymetricDelay::rampTaps(uint32_t spanStart, uint32_t n)
+{
+    double spb = sampleRate * 60.0 / tempoAt(samplesProcessed + spanStart + n);
+    for (int i = 0; i < nTaps; ++i)
+    {
+        auto nt = (int)(*tapData[i].ntaps);
+        auto m = (int)(*tapData[i].mbeats);
+        auto target = (float)(spb * m / nt);
+        tapSamplesInc[i] = (target - baseTapSamples[i]) / n;
+    }
+}
+
 void ConduitPolymetricDelay::recalcTaps()
 {
     // 120 beats per minute is
@@ -450,6 +637,7 @@ void ConduitPolymetricDelay::recalcTaps()
         auto n = (int)(*tapData[i].ntaps);
         auto m = (int)(*tapData[i].mbeats);
         baseTapSamples[i] = 1.f * spb * m / n;
+        tapSamplesInc[i] = 0.f;
         // CNDOUT << CNDVAR(n) << CNDVAR(m) << CNDVAR(spb) << CNDVAR(baseTapSamples[i]) <<
         // std::endl;
     }
@@ -459,10 +647,8 @@ void ConduitPolymetricDelay::recalcModulators()
 {
     for (int i = 0; i < nTaps; ++i)
     {
-        static constexpr double mf0{8.17579891564};
-        tapData[i].modulator.setRate(2.0 * M_PI *
-                                     note_to_pitch_ignoring_tuning(tapData[i].modrate.v + 69) *
-                                     mf0 * dsamplerate_inv);
+        tapData[i].modulator.setRate(2.0 * M_PI * noteToFrequency(tapData[i].modrate.v + 69) *
+                                     dsamplerate_inv);
     }
 }
 
@@ -41,6 +41,7 @@
 #include "sst/filters/BiquadFilter.h"
 
 #include "conduit-shared/clap-base-class.h"
+#include "conduit-shared/huge-page-arena.h"
 
 namespace sst::conduit::polymetric_delay
 {
@@ -52,6 +53,7 @@ struct ConduitPolymetricDelayConfig
     static constexpr int nParams{sst::conduit::polymetric_delay::nParams};
     static constexpr bool baseClassProvidesMonoModSupport{true};
     static constexpr bool usesSpecializedMessages{false};
+    static constexpr bool primeOnActivate{true};
     using PatchExtension = sst::conduit::shared::EmptyPatchExtension;
     struct DataCopyForUI
     {
@@ -80,6 +82,10 @@ struct ConduitPolymetricDelay
 
     bool activate(double sr, uint32_t minFrameCount, uint32_t maxFrameCount) noexcept override
     {
+        // Faulting in the huge pages is slow, so do it here once rather than on first use
+        if (delayLine.empty())
+            delayLine.allocate(2, st);
+
         setSampleRate(sr);
         recalcTaps();
         recalcModulators();
@@ -88,9 +94,19 @@ struct ConduitPolymetricDelay
         outVU.setSampleRate(sr);
         for (auto &t : tapOutVU)
             t.setSampleRate(sr);
+        for (auto &t : tapData)
+            t.filterInputs.invalidate();
+
+        warmUp();
         return true;
     }
 
+    template <typename F> void forEachWarmUpRegion(F &&f)
+    {
+        f(delayLine.begin(), delayLine.size() * sizeof(delayLine_t));
+    }
+    void primeKernels();
+
     static constexpr int nTaps{4};
     enum paramIds : uint32_t
     {
@@ -173,13 +189,14 @@ struct ConduitPolymetricDelay
     // This is enough for about 20 seconds of delay at 48khz
     sst::basic_blocks::tables::SurgeSincTableProvider st{};
     static constexpr uint32_t dlSize{1 << 20};
-    sst::basic_blocks::dsp::SSESincDelayLine<dlSize> delayLine[2]{st, st};
+    using delayLine_t = sst::basic_blocks::dsp::SSESincDelayLine<dlSize>;
+    sst::conduit::shared::HugePageArena<delayLine_t> delayLine;
 
   protected:
     std::unique_ptr<juce::Component> createEditor() override;
     std::atomic<bool> refreshUIValues{false};
 
-    float tapPanMatrix[nTaps][4];
+    float tapPanMatrix[nTaps][4]{};
 
     void specificParamChange(clap_id id, float val);
 
@@ -194,10 +211,31 @@ struct ConduitPolymetricDelay
         lag_t level, fblev, crossfblev, moddepth, modrate;
 
         sst::basic_blocks::dsp::QuadratureOscillator<float> modulator;
+
+        // The pan matrix and the filter coefficients only change with these params
+        sst::conduit::shared::DerivedValue<1> panInputs;
+        sst::conduit::shared::DerivedValue<2> filterInputs;
+        int filterRefreshBlocks{0};
     } tapData[nTaps];
 
     float baseTapSamples[nTaps]{};
-    float tempo;
+    double tempo{120}; // until the host sends a transport
+
+    /*
+     * The host sends a tempo and a per sample tempo_inc with each transport, good from
+     * the transport time until the next one. Rather than snapping the taps to every new
+     * tempo, each span sets up a ramp per tap from its current length to its length at
+     * the tempo at the span end, and the tap loop reads along that ramp. A tempo which
+     * jumps away from the ramp (a new song position, say) still snaps.
+     */
+    double tempoInc{0};
+    uint64_t tempoTime{0}, samplesProcessed{0};
+    float tapSamplesInc[nTaps]{};
+    static constexpr double tempoJumpTolerance{0.02};
+
+    double tempoAt(uint64_t t) const;
+    void tempoChanged(double newTempo, double newTempoInc, uint64_t at);
+    void rampTaps(uint32_t spanStart, uint32_t n);
 
     void recalcTaps();
     void recalcModulators();
@@ -211,6 +249,35 @@ struct ConduitPolymetricDelay
     }
 
     std::array<sst::filters::Biquad::BiquadFilter<ConduitPolymetricDelay, blockSize>, nTaps> hp, lp;
+
+    /*
+     * process runs in spans which end at the next event, the next block boundary or the
+     * end of the buffer, so nothing but the lags moves inside a span. The lag values are
+     * taken for the whole span up front. Then, if every active tap reaches back further
+     * than the span is long, all the tap reads only touch history and we read and filter
+     * each tap across the span in one go before writing the span back. Otherwise (very
+     * short taps) we interleave reads and writes a sample at a time, as the feedback
+     * requires. Both give the same output.
+     */
+    struct Span
+    {
+        bool active[nTaps];
+        float level alignas(16)[nTaps][blockSize], fblev alignas(16)[nTaps][blockSize];
+        float crossfblev alignas(16)[nTaps][blockSize], moddepth alignas(16)[nTaps][blockSize];
+        float tapOut alignas(16)[2][blockSize], tapFB alignas(16)[2][blockSize];
+        // the span's input and output, converted from and to the port format in one go
+        float in alignas(16)[2][blockSize], out alignas(16)[2][blockSize];
+        float inMx[2], outMx[2], tapMx[nTaps][2];
+    } span;
+
+    // Past the span length, the sinc read needs half its kernel of written history
+    static constexpr float spanHistoryGuard{
+        sst::basic_blocks::tables::SurgeSincTableProvider::FIRipol_N};
+
+    void beginSpan(uint32_t n);
+    bool spanReadsOnlyHistory(uint32_t n) const;
+    void processTaps(uint32_t from, uint32_t to, bool writesDeferred);
+    void writeSpan(uint32_t from, uint32_t to);
 };
 } // namespace sst::conduit::polymetric_delay
 
@@ -32,6 +32,10 @@ struct FXUtilityBase
 {
     ConduitPolysynth *synth{nullptr};
     FXUtilityBase(ConduitPolysynth *p, ConduitPolysynth *, ConduitPolysynth *) : synth(p) {}
+
+    // Which multi-timbral part's patch this effect instance reads
+    int part{0};
+    float partValue(clap_id id) const { return synth->partParamValue(part, id); }
 };
 } // namespace details
 
@@ -46,7 +50,7 @@ struct SharedConfig
 
     static float envelopeRateLinear(GlobalStorage *g, float f)
     {
-        return blockSize * sampleRateInv(g) * pow(2.f, -f);
+        return g->envelopeRateLinear(f, blockSize, sampleRateInv(g));
     }
     static bool isDeactivated(EffectStorage *, int) { return false; }
     static bool isExtended(EffectStorage *, int) { return false; }
@@ -74,9 +78,7 @@ struct PhaserConfig : SharedConfig
 
     static int presetIndex(const BaseClass *bc)
     {
-        auto s = bc->synth;
-        auto pn = s->paramToValue[ConduitPolysynth::pmModFXPreset];
-        return (int)std::round(*pn);
+        return (int)std::round(bc->partValue(ConduitPolysynth::pmModFXPreset));
     }
 
     static float temposyncRatio(GlobalStorage *g, EffectStorage *, int) { return 1.; }
@@ -85,12 +87,12 @@ struct PhaserConfig : SharedConfig
     {
         if (idx == PhaserFX::ph_mix)
         {
-            return *(bc->synth->paramToValue[ConduitPolysynth::pmModFXMix]);
+            return bc->partValue(ConduitPolysynth::pmModFXMix);
         }
 
         if (idx == PhaserFX::ph_mod_rate)
         {
-            return *(bc->synth->paramToValue[ConduitPolysynth::pmModFXRate]);
+            return bc->partValue(ConduitPolysynth::pmModFXRate);
         }
         return presets[presetIndex(bc)][idx];
     }
@@ -111,19 +113,17 @@ struct FlangerConfig : SharedConfig
 
     static int presetIndex(const BaseClass *bc)
     {
-        auto s = bc->synth;
-        auto pn = s->paramToValue[ConduitPolysynth::pmModFXPreset];
-        return (int)std::round(*pn);
+        return (int)std::round(bc->partValue(ConduitPolysynth::pmModFXPreset));
     }
     static float floatValueAt(const BaseClass *bc, const ValueStorage *, int idx)
     {
         if (idx == FlangerFX::fl_mix)
         {
-            return *(bc->synth->paramToValue[ConduitPolysynth::pmModFXMix]);
+            return bc->partValue(ConduitPolysynth::pmModFXMix);
         }
         if (idx == FlangerFX::fl_rate)
         {
-            return *(bc->synth->paramToValue[ConduitPolysynth::pmModFXRate]);
+            return bc->partValue(ConduitPolysynth::pmModFXRate);
         }
         return presets[presetIndex(bc)][idx];
     }
@@ -143,22 +143,33 @@ struct Reverb1Config : SharedConfig
 
     static float temposyncRatio(GlobalStorage *g, EffectStorage *, int) { return 1.; }
 
+    // The reverb may run below the host rate; see ConduitPolysynth::reverbDivisor. Its
+    // filters take the rate from the biquad adapter, so that has to be us too.
+    using BiquadAdapter = Reverb1Config;
+    static double sampleRate(GlobalStorage *g) { return g->sampleRate / g->reverbDivisor; }
+    static double sampleRateInv(GlobalStorage *g) { return g->sampleRateInv * g->reverbDivisor; }
+    static float envelopeRateLinear(GlobalStorage *g, float f)
+    {
+        return g->envelopeRateLinear(f, blockSize, sampleRateInv(g));
+    }
+
     static int presetIndex(const BaseClass *bc)
     {
-        auto s = bc->synth;
-        auto pn = s->paramToValue[ConduitPolysynth::pmRevFXPreset];
-        return (int)std::round(*pn);
+        return (int)std::round(bc->partValue(ConduitPolysynth::pmRevFXPreset));
     }
 
     static float floatValueAt(const BaseClass *bc, const ValueStorage *, int idx)
     {
         if (idx == ReverbFX::rev1_mix)
         {
-            return *(bc->synth->paramToValue[ConduitPolysynth::pmRevFXMix]);
+            // Below the host rate the synth mixes at full rate, so the reverb is all wet
+            if (bc->synth->reverbDivisor > 1)
+                return 1.f;
+            return bc->partValue(ConduitPolysynth::pmRevFXMix);
         }
         if (idx == ReverbFX::rev1_decaytime)
         {
-            return *(bc->synth->paramToValue[ConduitPolysynth::pmRevFXTime]);
+            return bc->partValue(ConduitPolysynth::pmRevFXTime);
         }
         return presets[presetIndex(bc)][idx];
     }
@@ -0,0 +1,270 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+
+#include "modulator-bank.h"
+#include "polysynth.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "sst/basic-blocks/dsp/FastMath.h"
+
+namespace sst::conduit::polysynth
+{
+namespace
+{
+// The level at which attack turns to decay
+constexpr float switchVolts{1.f};
+// A released envelope below this is at the end of its cycle
+constexpr float eocLevel{1e-6f};
+constexpr float pi{3.14159265358979323846f};
+} // namespace
+
+void ModulatorBank::process(PolysynthVoice *const *voices, size_t count)
+{
+    if (count == 0)
+        return;
+
+    auto rateOffset = envelopeRateOffset(voices[0]->samplerate);
+    for (size_t i = 0; i < count; i += lanes)
+    {
+        auto n = (int)std::min(count - i, (size_t)lanes);
+        processEnvelopes(voices + i, n, false, rateOffset);
+        processEnvelopes(voices + i, n, true, rateOffset);
+        processLFOs(voices + i, n, 0);
+        processLFOs(voices + i, n, 1);
+    }
+}
+
+void ModulatorBank::attack(PolysynthVoice::env_t &env, PolysynthVoice::AnalogEnvState &state)
+{
+    state = {};
+    env.stage = PolysynthVoice::env_t::s_attack;
+    env.outBlock0 = 0.f;
+    std::fill(env.outputCache, env.outputCache + blockSize, 0.f);
+}
+
+float ModulatorBank::envelopeRateOffset(double samplerate)
+{
+    // The block rate coefficient for a time of 2^t seconds is 2^(rateOffset - t)
+    return 2.f - std::log2((float)samplerate / blockSize);
+}
+
+float ModulatorBank::envelopeCoefficient(
+    const sst::basic_blocks::tables::TwoToTheXProvider &twoToX, float rateOffset, float v)
+{
+    using env_t = PolysynthVoice::env_t;
+    auto t = env_t::etMin + std::clamp(v, 0.f, 1.f) * (env_t::etMax - env_t::etMin);
+    return twoToX.twoToThe(std::min(0.f, rateOffset - t));
+}
+
+void ModulatorBank::stepEnvelopes(EnvLanes &e)
+{
+    const auto zero = _mm_setzero_ps();
+    const auto one = _mm_set1_ps(1.f);
+
+    auto c1 = _mm_load_ps(e.level);
+    auto gateV = _mm_load_ps(e.gate);
+    auto gated = _mm_cmpgt_ps(gateV, zero);
+
+    // Discharge latches once the level passes the switch voltage, until the gate drops
+    auto wasDischarging = _mm_castsi128_ps(_mm_load_si128((const __m128i *)e.discharge));
+    auto passed = _mm_cmpgt_ps(_mm_load_ps(e.delayed), _mm_set1_ps(switchVolts));
+    auto dis = _mm_and_ps(_mm_or_ps(passed, wasDischarging), gated);
+    auto attacking = _mm_andnot_ps(dis, gated);
+
+    auto dA = _mm_max_ps(zero, _mm_sub_ps(_mm_and_ps(attacking, gateV), c1));
+    auto dD = _mm_and_ps(dis, _mm_sub_ps(_mm_load_ps(e.sustain), c1));
+    auto dR = _mm_min_ps(zero, _mm_sub_ps(gateV, c1));
+
+    auto next = _mm_add_ps(c1, _mm_mul_ps(dA, _mm_load_ps(e.coefA)));
+    next = _mm_add_ps(next, _mm_mul_ps(dD, _mm_load_ps(e.coefD)));
+    next = _mm_add_ps(next, _mm_mul_ps(dR, _mm_load_ps(e.coefR)));
+
+    _mm_store_ps(e.delayed, c1);
+    _mm_store_ps(e.level, next);
+    _mm_store_si128((__m128i *)e.discharge, _mm_castps_si128(dis));
+
+    // The output ramps across the block from where the last block ended
+    auto out = _mm_min_ps(one, _mm_max_ps(zero, next));
+    auto from = _mm_load_ps(e.prior);
+    auto step = _mm_mul_ps(_mm_sub_ps(out, from), _mm_set1_ps(1.f / blockSize));
+    for (int s = 0; s < blockSize; ++s)
+        _mm_store_ps(e.cache[s], _mm_add_ps(from, _mm_mul_ps(step, _mm_set1_ps((float)(s + 1)))));
+    _mm_store_ps(e.prior, out);
+
+    e.gatedBits = _mm_movemask_ps(gated);
+    e.dischargeBits = _mm_movemask_ps(dis);
+    e.eocBits = _mm_movemask_ps(_mm_andnot_ps(gated, _mm_cmplt_ps(out, _mm_set1_ps(eocLevel))));
+}
+
+void ModulatorBank::processEnvelopes(PolysynthVoice *const *voices, int n, bool isFEG,
+                                     float rateOffset)
+{
+    using env_t = PolysynthVoice::env_t;
+    const auto &twoToX = voices[0]->synth.twoToXTable;
+
+    EnvLanes e;
+    for (int l = 0; l < n; ++l)
+    {
+        auto &v = *voices[l];
+        auto &values = isFEG ? v.fegValues : v.aegValues;
+        const auto &state = isFEG ? v.fegState : v.aegState;
+        const auto &env = isFEG ? v.feg : v.aeg;
+
+        e.level[l] = state.level;
+        e.delayed[l] = state.levelDelayed;
+        e.discharge[l] = state.discharge;
+        e.gate[l] = v.gated ? gateVolts : 0.f;
+        e.prior[l] = env.outputCache[blockSize - 1];
+
+        auto s = std::clamp(values.sustain.value(), 0.f, 1.f);
+        e.sustain[l] = s * s;
+        e.coefA[l] = envelopeCoefficient(twoToX, rateOffset, values.attack.value());
+        e.coefD[l] = envelopeCoefficient(twoToX, rateOffset, values.decay.value());
+        e.coefR[l] = envelopeCoefficient(twoToX, rateOffset, values.release.value());
+    }
+
+    stepEnvelopes(e);
+
+    for (int l = 0; l < n; ++l)
+    {
+        auto &v = *voices[l];
+        auto &state = isFEG ? v.fegState : v.aegState;
+        auto &env = isFEG ? v.feg : v.aeg;
+
+        state.level = e.level[l];
+        state.levelDelayed = e.delayed[l];
+        state.discharge = e.discharge[l];
+
+        for (int s = 0; s < blockSize; ++s)
+            env.outputCache[s] = e.cache[s][l];
+        env.outBlock0 = env.outputCache[0];
+
+        auto bit = 1 << l;
+        if (e.gatedBits & bit)
+            env.stage = (e.dischargeBits & bit) ? env_t::s_decay : env_t::s_attack;
+        else
+            env.stage = (e.eocBits & bit) ? env_t::s_eoc : env_t::s_release;
+    }
+}
+
+void ModulatorBank::stepLFOs(LfoLanes &l)
+{
+    using lfo_t = PolysynthVoice::lfo_t;
+
+    const auto zero = _mm_setzero_ps();
+    const auto one = _mm_set1_ps(1.f);
+    const auto half = _mm_set1_ps(0.5f);
+    const auto two = _mm_set1_ps(2.f);
+
+    // Phases are non-negative so truncation is floor
+    auto p = _mm_add_ps(_mm_load_ps(l.phase), _mm_load_ps(l.increment));
+    p = _mm_sub_ps(p, _mm_cvtepi32_ps(_mm_cvttps_epi32(p)));
+    _mm_store_ps(l.phase, p);
+
+    auto shapes = _mm_load_si128((const __m128i *)l.shape);
+    auto is = [shapes](int s) {
+        return _mm_castsi128_ps(_mm_cmpeq_epi32(shapes, _mm_set1_epi32(s)));
+    };
+
+    // sin(2 pi p) = -sin(2 pi (p - 1/2)), which keeps the argument in -pi...pi
+    auto sine = _mm_sub_ps(zero, sst::basic_blocks::dsp::fastsinSSE(
+                                     _mm_mul_ps(_mm_set1_ps(2 * pi), _mm_sub_ps(p, half))));
+    auto ramp = _mm_sub_ps(_mm_mul_ps(two, p), one);
+    auto downRamp = _mm_sub_ps(one, _mm_mul_ps(two, p));
+
+    auto tp = _mm_add_ps(p, _mm_set1_ps(0.25f));
+    tp = _mm_sub_ps(tp, _mm_and_ps(_mm_cmpgt_ps(tp, one), one));
+    auto fold = _mm_cmpgt_ps(tp, half);
+    tp = _mm_or_ps(_mm_and_ps(fold, _mm_sub_ps(one, tp)), _mm_andnot_ps(fold, tp));
+    auto tri = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(4.f), tp), one);
+
+    auto d = _mm_load_ps(l.deform);
+    auto pulse = _mm_cmplt_ps(p, _mm_mul_ps(_mm_add_ps(d, one), half));
+    pulse = _mm_or_ps(_mm_and_ps(pulse, one), _mm_andnot_ps(pulse, _mm_set1_ps(-1.f)));
+
+    auto x = _mm_and_ps(is(lfo_t::SINE), sine);
+    x = _mm_or_ps(x, _mm_and_ps(is(lfo_t::RAMP), ramp));
+    x = _mm_or_ps(x, _mm_and_ps(is(lfo_t::DOWN_RAMP), downRamp));
+    x = _mm_or_ps(x, _mm_and_ps(is(lfo_t::TRI), tri));
+
+    // Deform bends the continuous shapes; for the pulse it is the width
+    auto a = _mm_mul_ps(half, _mm_min_ps(_mm_set1_ps(3.f), _mm_max_ps(_mm_set1_ps(-3.f), d)));
+    for (int i = 0; i < 2; ++i)
+        x = _mm_add_ps(_mm_sub_ps(x, _mm_mul_ps(a, _mm_mul_ps(x, x))), a);
+
+    auto isPulse = is(lfo_t::PULSE);
+    auto target = _mm_or_ps(_mm_and_ps(isPulse, pulse), _mm_andnot_ps(isPulse, x));
+
+    auto from = _mm_load_ps(l.last);
+    auto step = _mm_mul_ps(_mm_sub_ps(target, from), _mm_set1_ps(1.f / blockSize));
+    for (int s = 0; s < blockSize; ++s)
+        _mm_store_ps(l.block[s], _mm_add_ps(from, _mm_mul_ps(step, _mm_set1_ps((float)s))));
+    _mm_store_ps(l.last, target);
+}
+
+void ModulatorBank::processLFOs(PolysynthVoice *const *voices, int n, int which)
+{
+    using lfo_t = PolysynthVoice::lfo_t;
+
+    LfoLanes lfoLanes;
+    int laneBits{0};
+    for (int l = 0; l < n; ++l)
+    {
+        auto &v = *voices[l];
+        auto &lfo = v.lfos[which];
+        auto &data = v.lfoData[which];
+
+        if (data.shape == lfo_t::SMOOTH_NOISE || data.shape == lfo_t::SH_NOISE)
+        {
+            lfo.process_block(data.rate.value(), data.deform.value(), data.shape);
+            continue;
+        }
+
+        laneBits |= 1 << l;
+        lfoLanes.phase[l] = lfo.phase;
+        lfoLanes.increment[l] = v.envelope_rate_linear_nowrap(-data.rate.value());
+        lfoLanes.deform[l] = data.deform.value();
+        lfoLanes.last[l] = lfo.lastTarget;
+        lfoLanes.shape[l] = data.shape;
+    }
+
+    if (!laneBits)
+        return;
+
+    stepLFOs(lfoLanes);
+
+    for (int l = 0; l < n; ++l)
+    {
+        if (!(laneBits & (1 << l)))
+            continue;
+
+        auto &lfo = voices[l]->lfos[which];
+        lfo.phase = lfoLanes.phase[l];
+        lfo.lastTarget = lfoLanes.last[l];
+        for (int s = 0; s < blockSize; ++s)
+            lfo.outputBlock[s] = lfoLanes.block[s][l];
+    }
+}
+} // namespace sst::conduit::polysynth
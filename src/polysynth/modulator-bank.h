@@ -0,0 +1,105 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+
+#ifndef CONDUIT_SRC_POLYSYNTH_MODULATOR_BANK_H
+#define CONDUIT_SRC_POLYSYNTH_MODULATOR_BANK_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "conduit-shared/sse-include.h"
+#include "sst/basic-blocks/tables/TwoToTheXProvider.h"
+#include "voice.h"
+
+namespace sst::conduit::polysynth
+{
+/*
+ * Runs the AEG, FEG and both LFOs of the playing voices four at a time, one voice per SSE
+ * lane. The state stays in each voice; the bank gathers it into lanes, advances a block and
+ * scatters it back, filling the same outBlock0, outputCache, stage and lastTarget the
+ * voice reads, so the rest of the voice cannot tell it did not run its own modulators.
+ *
+ * The envelopes are the analog ADSR: a capacitor charged towards a gate voltage which
+ * turns to decay once it passes one volt. Attack, decay, release and the end of cycle are
+ * per lane masks rather than branches, and the block rate coefficients come from the
+ * synth's 2^x table. The noise LFO shapes carry a random sequence in the LFO object, so
+ * lanes with those shapes run there instead.
+ */
+struct ModulatorBank
+{
+    static constexpr int lanes{4};
+    static constexpr int blockSize{PolysynthVoice::blockSizeOS};
+
+    static void process(PolysynthVoice *const *voices, size_t count);
+
+    // Restarts an envelope from silence in its attack stage
+    static void attack(PolysynthVoice::env_t &env, PolysynthVoice::AnalogEnvState &state);
+
+    /*
+     * The lane math on its own, so it can be checked against the sst ADSREnvelope and
+     * SimpleLFO without a synth (see benchmarks/kernels.cpp). Lanes past those in use
+     * should be left zeroed; they stay silent and released.
+     */
+    struct EnvLanes
+    {
+        // in
+        float gate alignas(16)[lanes]{}; // gateVolts when gated, else 0
+        float sustain alignas(16)[lanes]{};
+        float coefA alignas(16)[lanes]{}, coefD alignas(16)[lanes]{}, coefR alignas(16)[lanes]{};
+        // in and out
+        float level alignas(16)[lanes]{}, delayed alignas(16)[lanes]{};
+        float prior alignas(16)[lanes]{}; // the output at the end of the last block
+        int32_t discharge alignas(16)[lanes]{};
+        // out
+        float cache alignas(16)[blockSize][lanes];
+        int gatedBits{0}, dischargeBits{0}, eocBits{0};
+    };
+    static constexpr float gateVolts{1.5f};
+    static void stepEnvelopes(EnvLanes &e);
+
+    // The block rate coefficient for an attack, decay or release parameter in 0...1
+    static float envelopeCoefficient(const sst::basic_blocks::tables::TwoToTheXProvider &twoToX,
+                                     float rateOffset, float v);
+    // rateOffset for envelopeCoefficient at a sample rate
+    static float envelopeRateOffset(double samplerate);
+
+    struct LfoLanes
+    {
+        // in
+        float increment alignas(16)[lanes]{}; // phase per block
+        float deform alignas(16)[lanes]{};
+        int32_t shape alignas(16)[lanes]{};
+        // in and out
+        float phase alignas(16)[lanes]{}, last alignas(16)[lanes]{};
+        // out
+        float block alignas(16)[blockSize][lanes];
+    };
+    static void stepLFOs(LfoLanes &l);
+
+  private:
+    static void processEnvelopes(PolysynthVoice *const *voices, int n, bool isFEG,
+                                 float rateOffset);
+    static void processLFOs(PolysynthVoice *const *voices, int n, int which);
+};
+} // namespace sst::conduit::polysynth
+
+#endif // CONDUIT_SRC_POLYSYNTH_MODULATOR_BANK_H
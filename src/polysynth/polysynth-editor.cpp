@@ -20,6 +20,7 @@
  */
 
 #include "polysynth.h"
+#include <bitset>
 #include <juce_gui_basics/juce_gui_basics.h>
 
 #include "sst/jucegui/accessibility/Ignored.h"
@@ -361,6 +362,8 @@ struct StatusPanel : jcmp::NamedPanel
         {
             panel->mpeButton->widget->setBounds(0, 0, 200, 20);
             panel->voiceCountLabel->setBounds(0, 22, 200, 20);
+            panel->partsButton->setBounds(0, 44, 200, 20);
+            panel->polyphonyJog->setBounds(0, 66, 200, 20);
             panel->vuMeter->setBounds(getWidth() - 30, 0, 30, getHeight());
         }
 
@@ -403,6 +406,37 @@ struct StatusPanel : jcmp::NamedPanel
     std::unique_ptr<jcad::DiscreteToValueReference<jcmp::ToggleButton, bool>> mpeButton;
     bool mpeActive{false};
 
+    void pushMultiTimbralStatus(bool active, int keying)
+    {
+        auto ms = ConduitPolysynthConfig::SpecializedMessage::MultiTimbralConfig();
+        ms.active = active;
+        ms.keying = keying;
+
+        ConduitPolysynth::FromUI val;
+        val.type = ConduitPolysynth::FromUI::SPECIALIZED;
+        val.id = 0;
+        val.specializedMessage.payload = ms;
+
+        uic.fromUiQ.push(val);
+    }
+    void pushPartCommand(ConduitPolysynthConfig::SpecializedMessage::PartCommand::Command c,
+                         int part)
+    {
+        auto pc = ConduitPolysynthConfig::SpecializedMessage::PartCommand();
+        pc.command = c;
+        pc.part = part;
+
+        ConduitPolysynth::FromUI val;
+        val.type = ConduitPolysynth::FromUI::SPECIALIZED;
+        val.id = 0;
+        val.specializedMessage.payload = pc;
+
+        uic.fromUiQ.push(val);
+    }
+    void showPartsMenu();
+    std::unique_ptr<jcmp::MenuButton> partsButton;
+    std::unique_ptr<jcmp::JogUpDownButton> polyphonyJog;
+
     std::unique_ptr<jcmp::VUMeter> vuMeter;
     std::unique_ptr<jcmp::Label> voiceCountLabel;
 };
@@ -1030,6 +1064,18 @@ StatusPanel::StatusPanel(sst::conduit::polysynth::editor::uicomm_t &p,
     voiceCountLabel->setText("Voices: 0");
     content->addAndMakeVisible(*voiceCountLabel);
 
+    partsButton = std::make_unique<jcmp::MenuButton>();
+    partsButton->setLabel("Multi-Timbral: Off");
+    partsButton->setOnCallback([w = juce::Component::SafePointer(this)]() {
+        if (w)
+            w->showPartsMenu();
+    });
+    content->addAndMakeVisible(*partsButton);
+
+    polyphonyJog = std::make_unique<jcmp::JogUpDownButton>();
+    e.comms->attachDiscreteToParam(polyphonyJog.get(), ConduitPolysynth::pmPolyphony);
+    content->addAndMakeVisible(*polyphonyJog);
+
     setContentAreaComponent(std::move(content));
 
     ed.comms->addIdleHandler("status", [this]() { updateStatus(); });
@@ -1041,9 +1087,62 @@ void StatusPanel::updateStatus()
 {
     vuMeter->setLevels(uic.dataCopyForUI.mainVU[0], uic.dataCopyForUI.mainVU[1]);
     voiceCountLabel->setText("Voices : " + std::to_string(uic.dataCopyForUI.polyphony));
+
+    auto mask = uic.dataCopyForUI.activePartMask.load();
+    if (uic.dataCopyForUI.multiTimbral)
+    {
+        auto nParts = std::bitset<maxParts>(mask).count();
+        partsButton->setLabel("Multi-Timbral: " + std::to_string(nParts) + " Parts");
+    }
+    else
+    {
+        partsButton->setLabel("Multi-Timbral: Off");
+    }
     repaint();
 }
 
+void StatusPanel::showPartsMenu()
+{
+    using pc_t = ConduitPolysynthConfig::SpecializedMessage::PartCommand;
+    auto mtActive = uic.dataCopyForUI.multiTimbral.load();
+    auto mask = uic.dataCopyForUI.activePartMask.load();
+    auto keying = uic.dataCopyForUI.partKeying.load();
+
+    auto p = juce::PopupMenu();
+    p.addSectionHeader("Multi-Timbral Parts");
+    p.addSeparator();
+    p.addItem("Enabled", true, mtActive, [w = juce::Component::SafePointer(this), mtActive]() {
+        if (w)
+            w->pushMultiTimbralStatus(!mtActive, w->uic.dataCopyForUI.partKeying);
+    });
+    p.addItem("Part by MIDI Channel", true, keying == 0,
+              [w = juce::Component::SafePointer(this), mtActive]() {
+                  if (w)
+                      w->pushMultiTimbralStatus(mtActive, 0);
+              });
+    p.addItem("Part by Note Port", true, keying == 1,
+              [w = juce::Component::SafePointer(this), mtActive]() {
+                  if (w)
+                      w->pushMultiTimbralStatus(mtActive, 1);
+              });
+    p.addSeparator();
+    for (int i = 1; i < maxParts; ++i)
+    {
+        auto isActive = (bool)(mask & (1 << i));
+        auto sm = juce::PopupMenu();
+        sm.addItem("Copy Main Patch to Part", [w = juce::Component::SafePointer(this), i]() {
+            if (w)
+                w->pushPartCommand(pc_t::COPY_MAIN_TO_PART, i);
+        });
+        sm.addItem("Clear Part", isActive, false, [w = juce::Component::SafePointer(this), i]() {
+            if (w)
+                w->pushPartCommand(pc_t::CLEAR_PART, i);
+        });
+        p.addSubMenu("Part " + std::to_string(i + 1) + (isActive ? " (active)" : ""), sm);
+    }
+    p.showMenuAsync(juce::PopupMenu::Options());
+}
+
 ModFXPanel::ModFXPanel(sst::conduit::polysynth::editor::uicomm_t &p,
                        sst::conduit::polysynth::editor::ConduitPolysynthEditor &e)
     : jcmp::NamedPanel("Modulation Effect"), uic(p), ed(e)
@@ -23,6 +23,7 @@
 #include <iostream>
 #include <cmath>
 #include <cstring>
+#include <algorithm>
 
 #include <iomanip>
 #include <locale>
@@ -31,11 +32,15 @@
 
 #include "libMTSClient.h"
 
-#include "sst/cpputils/constructors.h"
+#include "conduit-shared/audio-port-io.h"
+
 #include "sst/basic-blocks/mechanics/block-ops.h"
 #include "sst/voicemanager/midi1_to_voicemanager.h"
 
 #include "effects-impl.h"
+#include "modulator-bank.h"
+#include "saw-wavetable.h"
+#include "waveshaper-tables.h"
 
 namespace sst::conduit::polysynth
 {
@@ -59,8 +64,7 @@ const clap_plugin_descriptor *ConduitPolysynthConfig::getDescription()
 
 ConduitPolysynth::ConduitPolysynth(const clap_host *host)
     : sst::conduit::shared::ClapBaseClass<ConduitPolysynth, ConduitPolysynthConfig>(host),
-      gen((size_t)this), urd(0.f, 1.f), hr_dn(6, true), voiceManager(*this),
-      voices{sst::cpputils::make_array<PolysynthVoice, max_voices>(*this)}
+      gen((size_t)this), urd(0.f, 1.f), voiceManager(*this)
 {
     auto autoFlag = CLAP_PARAM_IS_AUTOMATABLE;
     auto monoModFlag = autoFlag | CLAP_PARAM_IS_MODULATABLE;
@@ -90,6 +94,12 @@ ConduitPolysynth::ConduitPolysynth(const clap_host *host)
             .withFlags(steppedFlag)
             .withUnorderedMapFormatting(
                 {{-3, "/8"}, {-2, "/4"}, {-1, "/2"}, {0, "x1"}, {1, "x2"}, {2, "x4"}, {3, "x8"}});
+    auto oscModeBase = ParamDesc()
+                           .asInt()
+                           .withRange(0, 1)
+                           .withDefault(0)
+                           .withFlags(steppedFlag)
+                           .withUnorderedMapFormatting({{0, "DPW"}, {1, "Wavetable"}});
 
     paramDescriptions.push_back(
         activeBase.withID(pmSawActive).withName("Saw Active").withGroupName("Saw Oscillator"));
@@ -118,6 +128,9 @@ ConduitPolysynth::ConduitPolysynth(const clap_host *host)
         fineBase.withID(pmSawFine).withName("Saw Fine Tuning").withGroupName("Saw Oscillator"));
     paramDescriptions.push_back(
         levelBase.withID(pmSawLevel).withName("Saw Level").withGroupName("Saw Oscillator"));
+    paramDescriptions.push_back(oscModeBase.withID(pmSawOscMode)
+                                    .withName("Saw Oscillator Mode")
+                                    .withGroupName("Saw Oscillator"));
 
     paramDescriptions.push_back(
         activeBase.withID(pmPWActive).withName("Pulse Width Active").withGroupName("Pulse Width"));
@@ -138,6 +151,9 @@ ConduitPolysynth::ConduitPolysynth(const clap_host *host)
         fineBase.withID(pmPWFine).withName("Pulse Width Fine").withGroupName("Pulse Width"));
     paramDescriptions.push_back(
         levelBase.withID(pmPWLevel).withName("Pulse Width Level").withGroupName("Pulse Width"));
+    paramDescriptions.push_back(oscModeBase.withID(pmPWOscMode)
+                                    .withName("Pulse Width Oscillator Mode")
+                                    .withGroupName("Pulse Width"));
 
     paramDescriptions.push_back(activeBase.withID(pmSinActive)
                                     .withName("Sin Active")
@@ -288,6 +304,15 @@ ConduitPolysynth::ConduitPolysynth(const clap_host *host)
                                         {PolysynthVoice::Waveshapers::WestcoastFold, "Fold"},
                                         {PolysynthVoice::Waveshapers::Fuzz, "Fuzz"},
                                     })); // FIXME enums
+    paramDescriptions.push_back(ParamDesc()
+                                    .asInt()
+                                    .withID(pmWSTableMode)
+                                    .withDefault(0)
+                                    .withRange(0, 1)
+                                    .withName("WaveShaper Evaluation")
+                                    .withGroupName("WaveShaper")
+                                    .withFlags(steppedFlag)
+                                    .withUnorderedMapFormatting({{0, "Exact"}, {1, "Table"}}));
 
     paramDescriptions.push_back(ParamDesc()
                                     .asInt()
@@ -541,6 +566,16 @@ ConduitPolysynth::ConduitPolysynth(const clap_host *host)
                                     .withGroupName("Reverb FX")
                                     .withDefault(0.3)
                                     .withFlags(monoModFlag));
+    paramDescriptions.push_back(ParamDesc()
+                                    .asInt()
+                                    .withID(pmRevFXRate)
+                                    .withName("Reverb Rate")
+                                    .withGroupName("Reverb FX")
+                                    .withRange(0, 2)
+                                    .withDefault(0)
+                                    .withFlags(CLAP_PARAM_IS_STEPPED)
+                                    .withUnorderedMapFormatting(
+                                        {{0, "Full"}, {1, "Half"}, {2, "Quarter"}}));
 
     paramDescriptions.push_back(ParamDesc()
                                     .asCubicDecibelAttenuation()
@@ -549,9 +584,40 @@ ConduitPolysynth::ConduitPolysynth(const clap_host *host)
                                     .withGroupName("Global")
                                     .withFlags(monoModFlag)
                                     .withDefault(1.0));
+    paramDescriptions.push_back(ParamDesc()
+                                    .asInt()
+                                    .withID(pmPolyphony)
+                                    .withName("Polyphony")
+                                    .withGroupName("Global")
+                                    .withRange(1, max_voices)
+                                    .withDefault(default_voices)
+                                    .withFlags(CLAP_PARAM_IS_STEPPED)
+                                    .withLinearScaleFormatting("voices"));
 
     configureParams();
 
+    // Build the shared waveshaper and oscillator tables here, on the main thread, not at
+    // first voice start
+    WaveshaperTables::get();
+    SawWavetable::get();
+
+    patch.extension.initialize();
+    patchIndexById.fill(noPatchIndex);
+    for (const auto &[id, idx] : paramToPatchIndex)
+    {
+        cbassert(id <= maxParamId, "Param id " << id << " past maxParamId");
+        patchIndexById[id] = (uint8_t)idx;
+        paramRangeByIndex[idx] = paramDescriptionMap[id].maxVal - paramDescriptionMap[id].minVal;
+        patch.extension.paramIdsByIndex[idx] = id;
+        patch.extension.paramDefaultsByIndex[idx] = paramDescriptionMap[id].defaultVal;
+    }
+    for (auto &pp : patch.extension.partPatches)
+    {
+        std::copy(patch.extension.paramDefaultsByIndex.begin(),
+                  patch.extension.paramDefaultsByIndex.end(), pp.params);
+    }
+    bindParts();
+
     terminatedVoices.reserve(max_voices * 4);
 
     clapJuceShim = std::make_unique<sst::clap_juce_shim::ClapJuceShim>(this);
@@ -571,22 +637,17 @@ ConduitPolysynth::ConduitPolysynth(const clap_host *host)
         }
     }
 
-    phaserFX = std::make_unique<PhaserFX>(this, this, this);
-    phaserFX->initialize();
-
-    flangerFX = std::make_unique<FlangerFX>(this, this, this);
-    flangerFX->initialize();
+    parts[0].used = true;
 
-    reverbFX = std::make_unique<ReverbFX>(this, this, this);
-    reverbFX->initialize();
+    attachParam(pmPolyphony, polyphonyParam);
+    attachParam(pmRevFXRate, reverbRateParam);
 
-    for (auto &v : voices)
-    {
-        v.attachTo(*this);
-    }
+    matrixSnapshots = std::make_unique<MatrixSnapshotPool>();
+    for (int i = 0; i < maxParts; ++i)
+        publishMatrix(i);
 
-    patch.extension.initialize();
     uiComms.dataCopyForUI.populateMatrixView(patch.extension.modMatrixConfig);
+    publishPartState();
 }
 ConduitPolysynth::~ConduitPolysynth()
 {
@@ -603,15 +664,112 @@ bool ConduitPolysynth::activate(double sampleRate, uint32_t minFrameCount,
                                 uint32_t maxFrameCount) noexcept
 {
     setSampleRate(sampleRate);
+
+    auto nVoices = requestedPolyphony();
+    if (nVoices != voiceLimit)
+        allocateVoices(nVoices);
+    polyphonyRestartRequested = false;
+
+    auto priorLatency = latencyGet();
+    reverbDivisor = requestedReverbDivisor();
+    reverbRestartRequested = false;
+
     for (auto &v : voices)
         v.setSampleRate(sampleRate * 2); // run voices oversampled
-    phaserFX->onSampleRateChanged();
-    flangerFX->onSampleRateChanged();
-    reverbFX->onSampleRateChanged();
+    for (int i = 0; i < maxParts; ++i)
+    {
+        auto &pt = parts[i];
+        pt.used = (i == 0);
+
+        if (!partWantsFX(i))
+        {
+            pt.fx.reset();
+            continue;
+        }
+        if (!pt.fx)
+            pt.fx = std::make_unique<PartFX>(this, i);
+        pt.fx->reset();
+    }
+    partFXRestartRequested = false;
+    if (latencyGet() != priorLatency && _host.canUseLatency())
+        _host.latencyChanged();
     mainVU.setSampleRate(sampleRate);
+
+    warmUp();
     return true;
 }
 
+size_t ConduitPolysynth::requestedPolyphony() const
+{
+    return (size_t)std::clamp((int)std::round(*polyphonyParam), 1, max_voices);
+}
+
+int ConduitPolysynth::requestedReverbDivisor() const
+{
+    return 1 << std::clamp((int)std::round(*reverbRateParam), 0, 2);
+}
+
+uint32_t ConduitPolysynth::latencyGet() const noexcept
+{
+    return reverbDivisor > 1 ? reverbDivisor * PolysynthVoice::blockSize : 0;
+}
+
+void ConduitPolysynth::allocateVoices(size_t count)
+{
+    /*
+     * Anything still sounding has to leave the voice manager before its storage goes away.
+     * We are not processing here, so the NOTE_END for each goes out with the first block
+     * after the restart, which also brings the polyphony count back down.
+     */
+    for (auto &v : voices)
+    {
+        if (v.active)
+        {
+            v.active = false;
+            if (v.stolen)
+                continue;
+            terminatedVoices.emplace_back(v.portid, v.channel, v.key, v.note_id);
+            voiceEndCallback(&v);
+        }
+    }
+
+    voiceLimit = count;
+    voices.allocate(count + stealHeadroom, *this);
+    for (auto &v : voices)
+    {
+        v.attachTo(*this);
+    }
+
+    if (_host.canUseVoiceInfo())
+        _host.voiceInfoChanged();
+}
+
+void ConduitPolysynth::deactivate() noexcept
+{
+    if (notePortsDirty)
+        updateNotePorts();
+}
+
+uint32_t ConduitPolysynth::desiredNotePorts() const
+{
+    const auto &ext = patch.extension;
+    if (ext.multiTimbral && ext.partKeying == ConduitPolysynthConfig::PatchExtension::BY_PORT)
+        return maxParts;
+    return 1;
+}
+
+void ConduitPolysynth::updateNotePorts()
+{
+    notePortsDirty = false;
+    auto nPorts = desiredNotePorts();
+    if (nPorts != advertisedNotePorts)
+    {
+        advertisedNotePorts = nPorts;
+        if (_host.canUseNotePorts())
+            _host.notePortsRescan(CLAP_NOTE_PORTS_RESCAN_ALL);
+    }
+}
+
 /*
  * Stereo out, Midi in, in a pretty obvious way.
  * The only trick is the idi in also has NOTE_DIALECT_CLAP which provides us
@@ -626,7 +784,7 @@ bool ConduitPolysynth::audioPortsInfo(uint32_t index, bool isInput,
     info->id = 0;
     info->in_place_pair = CLAP_INVALID_ID;
     strncpy(info->name, "main", sizeof(info->name));
-    info->flags = CLAP_AUDIO_PORT_IS_MAIN;
+    info->flags = CLAP_AUDIO_PORT_IS_MAIN | CLAP_AUDIO_PORT_SUPPORTS_64BITS;
     info->channel_count = 2;
     info->port_type = CLAP_PORT_STEREO;
 
@@ -636,12 +794,15 @@ bool ConduitPolysynth::audioPortsInfo(uint32_t index, bool isInput,
 bool ConduitPolysynth::notePortsInfo(uint32_t index, bool isInput,
                                      clap_note_port_info *info) const noexcept
 {
-    if (isInput)
+    if (isInput && index < advertisedNotePorts)
     {
-        info->id = 1;
+        info->id = 1 + index;
         info->supported_dialects = CLAP_NOTE_DIALECT_MIDI | CLAP_NOTE_DIALECT_CLAP;
         info->preferred_dialect = CLAP_NOTE_DIALECT_CLAP;
-        strncpy(info->name, "NoteInput", CLAP_NAME_SIZE - 1);
+        if (advertisedNotePorts == 1)
+            strncpy(info->name, "NoteInput", CLAP_NAME_SIZE - 1);
+        else
+            snprintf(info->name, CLAP_NAME_SIZE, "Part %d", index + 1);
         return true;
     }
     return false;
@@ -670,6 +831,9 @@ clap_process_status ConduitPolysynth::process(const clap_process *process) noexc
     if (process->audio_outputs_count <= 0)
         return CLAP_PROCESS_SLEEP;
 
+    // Matrix snapshots we load from here on stay valid until we return
+    MatrixSnapshotPool::ReadSection matrixReadSection(*matrixSnapshots);
+
     /*
      * Stage 1:
      *
@@ -680,6 +844,22 @@ clap_process_status ConduitPolysynth::process(const clap_process *process) noexc
     if (ct)
         pushParamsToVoices();
 
+    if (matrixDirtyMask.load(std::memory_order_relaxed))
+        publishDirtyMatrices();
+
+    // Voice storage is only resized in activate, so a polyphony change asks for a restart
+    if (!polyphonyRestartRequested && requestedPolyphony() != voiceLimit)
+    {
+        polyphonyRestartRequested = true;
+        _host.requestRestart();
+    }
+    // and so is the reverb rate, since it moves the latency
+    if (!reverbRestartRequested && requestedReverbDivisor() != reverbDivisor)
+    {
+        reverbRestartRequested = true;
+        _host.requestRestart();
+    }
+
     /*
      * Stage 2: Create the AUDIO output and process events
      *
@@ -688,8 +868,8 @@ clap_process_status ConduitPolysynth::process(const clap_process *process) noexc
      * and other events with audio generation. Here we do everything completely sample accurately
      * by maintaining a pointer to the 'nextEvent' which we check at every sample.
      */
-    float **out = process->audio_outputs[0].data32;
-    auto chans = process->audio_outputs->channel_count;
+    const auto &out = process->audio_outputs[0];
+    auto chans = out.channel_count;
     if (chans != 2)
     {
         return CLAP_PROCESS_SLEEP;
@@ -706,6 +886,9 @@ clap_process_status ConduitPolysynth::process(const clap_process *process) noexc
         nextEvent = ev->get(ev, nextEventIndex);
     }
 
+    // Dense automation is followed as a ramp across our 8 sample blocks; see renderVoices
+    scanParamRamps(ev);
+
     if (process->transport)
     {
         auto tev = process->transport;
@@ -721,10 +904,7 @@ clap_process_status ConduitPolysynth::process(const clap_process *process) noexc
             (tev->flags & CLAP_TRANSPORT_IS_PLAYING) || (tev->flags & CLAP_TRANSPORT_IS_RECORDING);
     }
 
-    bool modActive = *paramToValue[pmModFXActive] > 0.5;
-    bool revActive = *paramToValue[pmRevFXActive] > 0.5;
-    bool usePhaser = *paramToValue[pmModFXType] < 0.5;
-
+    uint32_t spanStart{0};
     for (auto i = 0U; i < process->frames_count; ++i)
     {
         // Do I have an event to process. Note that multiple events
@@ -743,30 +923,25 @@ clap_process_status ConduitPolysynth::process(const clap_process *process) noexc
 
         if (blockPos == 0)
         {
+            applyParamRamps(i, i + PolysynthVoice::blockSize);
             renderVoices();
-            if (modActive)
-            {
-                if (usePhaser)
-                {
-                    phaserFX->processBlock(output[0], output[1]);
-                }
-                else
-                {
-                    flangerFX->processBlock(output[0], output[1]);
-                }
-            }
-            if (revActive)
-            {
-                reverbFX->processBlock(output[0], output[1]);
-            }
             mainVU.process<PolysynthVoice::blockSize>(output[0], output[1]);
             uiComms.dataCopyForUI.mainVU[0] = mainVU.vu_peak[0];
             uiComms.dataCopyForUI.mainVU[1] = mainVU.vu_peak[1];
         }
-        out[0][i] = output[0][blockPos];
-        out[1][i] = output[1][blockPos];
 
         blockPos = (blockPos + 1) & (PolysynthVoice::blockSize - 1);
+
+        // Copy out a span at a time, at the end of each block and of the buffer, which
+        // lets a 64 bit output convert with SIMD as it goes
+        if (blockPos == 0 || i + 1 == process->frames_count)
+        {
+            auto n = i + 1 - spanStart;
+            auto from = (blockPos == 0 ? PolysynthVoice::blockSize : blockPos) - n;
+            shared::storeSpan(out, 0, spanStart, output[0] + from, n);
+            shared::storeSpan(out, 1, spanStart, output[1] + from, n);
+            spanStart = i + 1;
+        }
     }
 
     /*
@@ -776,16 +951,20 @@ clap_process_status ConduitPolysynth::process(const clap_process *process) noexc
      * modulators, and it is also the reason we have the NEWLY_OFF state in addition
      * to the OFF state.
      *
-     * Note that there are two ways to enter the terminatedVoices array. The first
-     * is here through natural state transition to NEWLY_OFF and the second is in
-     * handleNoteOn when we steal a voice.
+     * Note that there are three ways to enter the terminatedVoices array. The first
+     * is here through natural state transition to NEWLY_OFF, the second is in
+     * handleNoteOn when we steal a voice and the third is allocateVoices when a
+     * polyphony restart drops the voices still sounding.
      */
     for (auto &v : voices)
     {
         if (v.active && !v.isPlaying())
         {
-            terminatedVoices.emplace_back(v.portid, v.channel, v.key, v.note_id);
             v.active = false;
+            // a stolen voice already left the voice manager when its fade began
+            if (v.stolen)
+                continue;
+            terminatedVoices.emplace_back(v.portid, v.channel, v.key, v.note_id);
             voiceEndCallback(&v);
         }
     }
@@ -822,20 +1001,154 @@ clap_process_status ConduitPolysynth::process(const clap_process *process) noexc
 
 void ConduitPolysynth::renderVoices()
 {
-    memset(outputOS, 0, sizeof(outputOS));
+    for (int i = 0; i < maxParts; ++i)
+    {
+        if (parts[i].used)
+        {
+            memset(parts[i].outputOS, 0, sizeof(parts[i].outputOS));
+            updatePartUniforms(i);
+        }
+    }
+
+    size_t nPlaying{0};
     for (auto &v : voices)
     {
         if (v.isPlaying())
+            playingVoices[nPlaying++] = &v;
+    }
+
+    ModulatorBank::process(playingVoices.data(), nPlaying);
+
+    for (size_t i = 0; i < nPlaying; ++i)
+    {
+        auto &v = *playingVoices[i];
+        v.processBlock();
+        auto &pt = parts[v.part];
+        sst::basic_blocks::mechanics::accumulate_from_to<PolysynthVoice::blockSizeOS>(
+            v.outputOS[0], pt.outputOS[0]);
+        sst::basic_blocks::mechanics::accumulate_from_to<PolysynthVoice::blockSizeOS>(
+            v.outputOS[1], pt.outputOS[1]);
+    }
+
+    memset(output, 0, sizeof(output));
+    for (int i = 0; i < maxParts; ++i)
+    {
+        auto &pt = parts[i];
+        if (!pt.used)
+            continue;
+
+        pt.hr_dn.process_block_D2(pt.outputOS[0], pt.outputOS[1], blockSize, pt.output[0],
+                                  pt.output[1]);
+
+        if (partParamValue(i, pmModFXActive) > 0.5)
         {
-            v.processBlock();
-            sst::basic_blocks::mechanics::accumulate_from_to<PolysynthVoice::blockSizeOS>(
-                v.outputOS[0], outputOS[0]);
-            sst::basic_blocks::mechanics::accumulate_from_to<PolysynthVoice::blockSizeOS>(
-                v.outputOS[1], outputOS[1]);
+            if (partParamValue(i, pmModFXType) < 0.5)
+            {
+                pt.fx->phaser.processBlock(pt.output[0], pt.output[1]);
+            }
+            else
+            {
+                pt.fx->flanger.processBlock(pt.output[0], pt.output[1]);
+            }
+        }
+        if (reverbDivisor > 1)
+        {
+            processReducedRateReverb(i);
+        }
+        else if (partParamValue(i, pmRevFXActive) > 0.5)
+        {
+            pt.fx->reverb.processBlock(pt.output[0], pt.output[1]);
+        }
+
+        sst::basic_blocks::mechanics::accumulate_from_to<PolysynthVoice::blockSize>(pt.output[0],
+                                                                                   output[0]);
+        sst::basic_blocks::mechanics::accumulate_from_to<PolysynthVoice::blockSize>(pt.output[1],
+                                                                                   output[1]);
+    }
+}
+
+/*
+ * One block of a part through the reduced rate reverb. The block swaps places with the
+ * dry reverbDivisor blocks back in revIn, which is mixed with its wet and output. Once a
+ * whole reverb block is gathered it is decimated, reverberated and upsampled into revWet.
+ * The dry path stays full band and delayed exactly by latencyGet() even with the reverb
+ * off, so the reported latency never moves.
+ */
+void ConduitPolysynth::processReducedRateReverb(int part)
+{
+    static constexpr int bs{PolysynthVoice::blockSize};
+    auto &pt = parts[part];
+    auto &fx = *pt.fx;
+    auto off = fx.revPos * bs;
+
+    auto active = partParamValue(part, pmRevFXActive) > 0.5;
+    auto mix = active ? partParamValue(part, pmRevFXMix) : 0.f;
+    auto dmix = (mix - fx.revMix) / bs;
+    for (int c = 0; c < 2; ++c)
+    {
+        auto m = fx.revMix;
+        for (int s = 0; s < bs; ++s)
+        {
+            m += dmix;
+            auto dry = fx.revIn[c][off + s];
+            fx.revIn[c][off + s] = pt.output[c][s];
+            pt.output[c][s] = dry + m * (fx.revWet[c][off + s] - dry);
         }
     }
+    fx.revMix = mix;
+
+    if (++fx.revPos < reverbDivisor)
+        return;
+    fx.revPos = 0;
+
+    if (!active)
+    {
+        memset(fx.revWet, 0, sizeof(fx.revWet));
+        return;
+    }
+
+    // The half rate filters count samples at their higher rate
+    float mid alignas(16)[2][bs * 2], rev alignas(16)[2][bs];
+    if (reverbDivisor == 4)
+    {
+        fx.rev_dn1.process_block_D2(fx.revIn[0], fx.revIn[1], bs * 4, mid[0], mid[1]);
+        fx.rev_dn2.process_block_D2(mid[0], mid[1], bs * 2, rev[0], rev[1]);
+    }
+    else
+    {
+        fx.rev_dn1.process_block_D2(fx.revIn[0], fx.revIn[1], bs * 2, rev[0], rev[1]);
+    }
+
+    fx.reverb.processBlock(rev[0], rev[1]);
+
+    if (reverbDivisor == 4)
+    {
+        fx.rev_up2.process_block_U2(rev[0], rev[1], mid[0], mid[1], bs * 2);
+        fx.rev_up1.process_block_U2(mid[0], mid[1], fx.revWet[0], fx.revWet[1], bs * 4);
+    }
+    else
+    {
+        fx.rev_up1.process_block_U2(rev[0], rev[1], fx.revWet[0], fx.revWet[1], bs * 2);
+    }
+}
+
+void ConduitPolysynth::updatePartUniforms(int part)
+{
+    auto &u = parts[part].uniforms;
+
+    u.aegPFGLinear = dbToLinear(partParamValue(part, pmAegPreFilterGain));
+    u.wsDriveLinear = dbToLinear(partParamValue(part, pmWSDrive));
+
+    u.sawLevelCubed = cubed(partParamValue(part, pmSawLevel));
+    u.pulseLevelCubed = cubed(partParamValue(part, pmPWLevel));
+    u.sinLevelCubed = cubed(partParamValue(part, pmSinLevel));
+    u.noiseLevelCubed = cubed(partParamValue(part, pmNoiseLevel));
+    u.outputLevelCubed = cubed(partParamValue(part, pmVoiceLevel));
 
-    hr_dn.process_block_D2(outputOS[0], outputOS[1], blockSize, output[0], output[1]);
+    auto pan = partParamValue(part, pmVoicePan);
+    u.outputPanCentered = (pan == 0.f);
+    if (!u.outputPanCentered)
+        sst::basic_blocks::dsp::pan_laws::stereoTruePanning((pan + 1) * 0.5, u.outputPanMatrix);
 }
 
 /*
@@ -866,14 +1179,15 @@ void ConduitPolysynth::handleInboundEvent(const clap_event_header_t *evt)
          * that) streams to do with as you wish. The CLAP_MIDI_EVENT here does the obvious thing.
          */
         auto mevt = reinterpret_cast<const clap_event_midi *>(evt);
+        if (updateChannelControllers(mevt->port_index, mevt->data))
+            break;
         sst::voicemanager::applyMidi1Message(voiceManager, mevt->port_index, mevt->data);
         break;
     }
     /*
      * CLAP_EVENT_NOTE_ON and OFF simply deliver the event to the note creators below,
-     * which find (probably) and activate a spare or playing voice. Our 'voice stealing'
-     * algorithm here is 'just don't play a note 65 if 64 are ringing. Remember this is an
-     * example synth!
+     * which find and activate a spare voice or, if all voices are busy, steal one. The
+     * voice pool is shared by all the multi-timbral parts so stealing crosses parts.
      */
     case CLAP_EVENT_NOTE_ON:
     {
@@ -897,6 +1211,8 @@ void ConduitPolysynth::handleInboundEvent(const clap_event_header_t *evt)
     case CLAP_EVENT_PARAM_VALUE:
     {
         auto v = reinterpret_cast<const clap_event_param_value *>(evt);
+        if (paramRampCovers(v))
+            break;
         updateParamInPatch(v);
         pushParamsToVoices();
     }
@@ -932,24 +1248,178 @@ void ConduitPolysynth::handleInboundEvent(const clap_event_header_t *evt)
 PolysynthVoice *ConduitPolysynth::initializeVoice(uint16_t port, uint16_t channel, uint16_t key,
                                                   int32_t noteId, float velocity, float retune)
 {
+    PolysynthVoice *res{nullptr};
+    size_t held{0};
     for (auto &v : voices)
     {
         if (!v.active)
         {
-            activateVoice(v, port, channel, key, noteId, velocity);
+            if (!res)
+                res = &v;
+        }
+        else if (!v.stolen)
+        {
+            held++;
+        }
+    }
+    if (held >= voiceLimit)
+        stealVoice();
+    if (!res)
+        res = reclaimFadingVoice();
+    if (!res)
+        return nullptr;
 
-            if (clapJuceShim->isEditorAttached())
-            {
-                auto r = ToUI();
-                r.type = ToUI::MIDI_NOTE_ON;
-                r.id = (uint32_t)key;
-                uiComms.toUiQ.push(r);
-            }
+    activateVoice(*res, partFor(port, channel), port, channel, key, noteId, velocity);
+
+    if (clapJuceShim->isEditorAttached())
+    {
+        auto r = ToUI();
+        r.type = ToUI::MIDI_NOTE_ON;
+        r.id = (uint32_t)key;
+        uiComms.toUiQ.push(r);
+    }
+
+    return res;
+}
+
+bool ConduitPolysynth::updateChannelControllers(uint16_t port, const uint8_t *data)
+{
+    auto status = data[0] & 0xF0;
+    auto &cc = channelControllers[std::min<int>(port, maxParts - 1)][data[0] & 0x0F];
 
-            return &v;
+    switch (status)
+    {
+    case 0xB0:
+    {
+        auto num = data[1] & 0x7F;
+        cc.midi1CC[num] = 1.f * (data[2] & 0x7F) / 127.f;
+        cc.version++;
+
+        // Data entry and (N)RPN, the pedals, and channel mode messages still need the
+        // voice manager
+        auto vmNeeds = num == 6 || num == 38 || (num >= 64 && num <= 69) ||
+                       (num >= 96 && num <= 101) || num >= 120;
+        return !vmNeeds;
+    }
+    case 0xD0:
+        cc.channelPressure = 1.f * (data[1] & 0x7F) / 127.f;
+        cc.version++;
+        return true;
+    case 0xE0:
+    {
+        auto pb14bit = (data[1] & 0x7F) + ((data[2] & 0x7F) << 7);
+        cc.pitchBend = (pb14bit - 8192) / 8192.f;
+        cc.version++;
+        return true;
+    }
+    default:
+        break;
+    }
+    return false;
+}
+
+const ChannelControllers *ConduitPolysynth::mpeGlobalControllersFor(int port, int channel) const
+{
+    if (voiceManager.dialect != voiceManager_t::MIDI1_MPE || channel == mpeGlobalChannel)
+        return nullptr;
+    return &channelControllersFor(port, mpeGlobalChannel);
+}
+
+void ConduitPolysynth::stealVoice()
+{
+    PolysynthVoice *oldest{nullptr}, *oldestReleased{nullptr};
+    for (auto &v : voices)
+    {
+        if (!v.active || v.stolen)
+            continue;
+        if (!oldest || v.startOrder < oldest->startOrder)
+            oldest = &v;
+        if (!v.gated && (!oldestReleased || v.startOrder < oldestReleased->startOrder))
+            oldestReleased = &v;
+    }
+
+    auto res = oldestReleased ? oldestReleased : oldest;
+    if (res)
+    {
+        // The NOTE_END for the stolen voice goes out with the naturally ended ones
+        terminatedVoices.emplace_back(res->portid, res->channel, res->key, res->note_id);
+        voiceEndCallback(res);
+        res->beginStealFade();
+    }
+}
+
+PolysynthVoice *ConduitPolysynth::reclaimFadingVoice()
+{
+    PolysynthVoice *res{nullptr};
+    for (auto &v : voices)
+    {
+        if (v.active && v.stolen && (!res || v.stealFadeRemaining < res->stealFadeRemaining))
+            res = &v;
+    }
+    if (res)
+        res->active = false;
+    return res;
+}
+
+int ConduitPolysynth::partFor(int port, int channel) const
+{
+    const auto &ext = patch.extension;
+    if (!ext.multiTimbral)
+        return 0;
+
+    auto p = (ext.partKeying == ConduitPolysynthConfig::PatchExtension::BY_PORT) ? port : channel;
+    if (p <= 0 || p >= maxParts || !ext.partPatches[p - 1].active || !parts[p].fx)
+        return 0;
+    return p;
+}
+
+bool ConduitPolysynth::partWantsFX(int part) const
+{
+    const auto &ext = patch.extension;
+    return part == 0 || (ext.multiTimbral && ext.partPatches[part - 1].active);
+}
+
+void ConduitPolysynth::requestPartFXIfMissing()
+{
+    if (!isActive() || partFXRestartRequested)
+        return;
+
+    for (int i = 1; i < maxParts; ++i)
+    {
+        if (partWantsFX(i) && !parts[i].fx)
+        {
+            partFXRestartRequested = true;
+            _host.requestRestart();
+            return;
         }
     }
-    return nullptr;
+}
+
+ConduitPolysynth::PartFX::PartFX(ConduitPolysynth *synth, int part)
+    : phaser(synth, synth, synth), flanger(synth, synth, synth), reverb(synth, synth, synth)
+{
+    phaser.part = part;
+    phaser.initialize();
+    flanger.part = part;
+    flanger.initialize();
+    reverb.part = part;
+    reverb.initialize();
+}
+
+void ConduitPolysynth::PartFX::reset()
+{
+    phaser.onSampleRateChanged();
+    flanger.onSampleRateChanged();
+    reverb.onSampleRateChanged();
+
+    memset(revIn, 0, sizeof(revIn));
+    memset(revWet, 0, sizeof(revWet));
+    revMix = 0.f;
+    revPos = 0;
+    rev_dn1.reset();
+    rev_dn2.reset();
+    rev_up1.reset();
+    rev_up2.reset();
 }
 
 void ConduitPolysynth::releaseVoice(PolysynthVoice *sdv, float velocity)
@@ -969,9 +1439,12 @@ void ConduitPolysynth::releaseVoice(PolysynthVoice *sdv, float velocity)
     }
 }
 
-void ConduitPolysynth::activateVoice(PolysynthVoice &v, int port_index, int channel, int key,
-                                     int noteid, double velocity)
+void ConduitPolysynth::activateVoice(PolysynthVoice &v, int part, int port_index, int channel,
+                                     int key, int noteid, double velocity)
 {
+    parts[part].used = true;
+    v.startOrder = voiceStartCounter++;
+    v.bindToPart(part);
     v.start(port_index, channel, key, noteid, velocity);
     uiComms.dataCopyForUI.polyphony++;
 }
@@ -984,6 +1457,7 @@ void ConduitPolysynth::activateVoice(PolysynthVoice &v, int port_index, int chan
 void ConduitPolysynth::paramsFlush(const clap_input_events *in,
                                    const clap_output_events *out) noexcept
 {
+    paramRamps.clear();
     auto sz = in->size(in);
 
     // This pointer is the sentinel to our next event which we advance once an event is processed
@@ -1007,6 +1481,80 @@ void ConduitPolysynth::pushParamsToVoices() {}
 void ConduitPolysynthConfig::PatchExtension::initialize()
 {
     modMatrixConfig = std::make_unique<ModMatrixConfig>();
+    for (auto &pp : partPatches)
+        pp.modMatrixConfig = std::make_unique<ModMatrixConfig>();
+}
+
+/*
+ * The part runtimes point into the patch storage, which is allocated once in the
+ * extension initialize and never reallocated, so this only needs to run at construction.
+ */
+void ConduitPolysynth::bindParts()
+{
+    parts[0].params = patch.params;
+    parts[0].modMatrix = patch.extension.modMatrixConfig.get();
+    for (int i = 1; i < maxParts; ++i)
+    {
+        auto &pp = patch.extension.partPatches[i - 1];
+        parts[i].params = pp.params;
+        parts[i].modMatrix = pp.modMatrixConfig.get();
+    }
+}
+
+bool ConduitPolysynth::publishMatrix(int part)
+{
+    auto *snap = matrixSnapshots->acquire();
+    if (!snap)
+    {
+        matrixDirtyMask.fetch_or(1u << part);
+        return false;
+    }
+
+    snap->value.routings = parts[part].modMatrix->routings;
+    for (auto i = 0U; i < snap->value.routings.size(); ++i)
+    {
+        auto tgt = snap->value.routings[i].target;
+        auto valid = tgt <= maxParamId && patchIndexById[tgt] != noPatchIndex;
+        snap->value.targetRanges[i] = valid ? paramRangeByIndex[patchIndexById[tgt]] : 0.f;
+    }
+    matrixSnapshots->publish(parts[part].matrix, snap);
+    return true;
+}
+
+void ConduitPolysynth::publishDirtyMatrices()
+{
+    auto mask = matrixDirtyMask.exchange(0);
+    for (int i = 0; i < maxParts; ++i)
+    {
+        if (mask & (1u << i))
+            publishMatrix(i);
+    }
+
+    // The snapshots we just retired are returned to the pool on the main thread
+    _host.requestCallback();
+}
+
+void ConduitPolysynth::onMainThread() noexcept
+{
+    if (matrixSnapshots->reclaim())
+        _host.requestCallback();
+
+    sst::conduit::shared::ClapBaseClass<ConduitPolysynth, ConduitPolysynthConfig>::onMainThread();
+}
+
+void ConduitPolysynth::publishPartState()
+{
+    const auto &ext = patch.extension;
+    uint32_t mask{1};
+    for (int i = 1; i < maxParts; ++i)
+    {
+        if (ext.partPatches[i - 1].active)
+            mask |= 1 << i;
+    }
+    uiComms.dataCopyForUI.multiTimbral = ext.multiTimbral;
+    uiComms.dataCopyForUI.activePartMask = mask;
+    uiComms.dataCopyForUI.partKeying = (int32_t)ext.partKeying;
+    uiComms.dataCopyForUI.updateCount++;
 }
 
 void ConduitPolysynth::handleSpecializedFromUI(const FromUI &r)
@@ -1021,6 +1569,7 @@ void ConduitPolysynth::handleSpecializedFromUI(const FromUI &r)
         rt.via = (ModMatrixConfig::Sources)sm.s2;
         rt.target = (ConduitPolysynth::paramIds)sm.tgt;
         rt.depth = sm.depth;
+        matrixDirtyMask.fetch_or(1u);
         uiComms.dataCopyForUI.populateMatrixView(patch.extension.modMatrixConfig);
     }
     else if (std::holds_alternative<smt::MPEConfig>(smw.payload))
@@ -1028,6 +1577,44 @@ void ConduitPolysynth::handleSpecializedFromUI(const FromUI &r)
         auto &mp = std::get<smt::MPEConfig>(smw.payload);
         voiceManager.dialect = (mp.active ? voiceManager_t::MIDI1_MPE : voiceManager_t::MIDI1);
     }
+    else if (std::holds_alternative<smt::MultiTimbralConfig>(smw.payload))
+    {
+        auto &mt = std::get<smt::MultiTimbralConfig>(smw.payload);
+        auto &ext = patch.extension;
+        ext.multiTimbral = mt.active;
+        ext.partKeying = (ConduitPolysynthConfig::PatchExtension::PartKeying)mt.keying;
+
+        // Changing the number of note ports needs a restart; the rescan happens in deactivate
+        if (desiredNotePorts() != advertisedNotePorts)
+        {
+            notePortsDirty = true;
+            _host.requestRestart();
+        }
+        requestPartFXIfMissing();
+        publishPartState();
+    }
+    else if (std::holds_alternative<smt::PartCommand>(smw.payload))
+    {
+        auto &pc = std::get<smt::PartCommand>(smw.payload);
+        if (pc.part <= 0 || pc.part >= maxParts)
+            return;
+
+        auto &pp = patch.extension.partPatches[pc.part - 1];
+        switch (pc.command)
+        {
+        case smt::PartCommand::COPY_MAIN_TO_PART:
+            memcpy(pp.params, patch.params, sizeof(pp.params));
+            pp.modMatrixConfig->routings = patch.extension.modMatrixConfig->routings;
+            matrixDirtyMask.fetch_or(1u << pc.part);
+            pp.active = true;
+            break;
+        case smt::PartCommand::CLEAR_PART:
+            pp.active = false;
+            break;
+        }
+        requestPartFXIfMissing();
+        publishPartState();
+    }
     else
     {
         CNDOUT << "WARNING: Unhandled specialized variant" << std::endl;
@@ -1046,12 +1633,12 @@ void ConduitPolysynthConfig::DataCopyForUI::populateMatrixView(
     rescanMatrix++;
 }
 
-bool ConduitPolysynthConfig::PatchExtension::toXml(TiXmlElement &root)
+static void matrixToXml(const ModMatrixConfig &config, TiXmlElement &root)
 {
     TiXmlElement matrix("matrix");
 
     int idx{0};
-    for (auto &el : modMatrixConfig->routings)
+    for (auto &el : config.routings)
     {
         TiXmlElement rt("routing");
         rt.SetAttribute("idx", idx);
@@ -1065,15 +1652,15 @@ bool ConduitPolysynthConfig::PatchExtension::toXml(TiXmlElement &root)
     }
 
     root.InsertEndChild(matrix);
-    return true;
 }
 
-bool ConduitPolysynthConfig::PatchExtension::fromXml(TiXmlElement *root)
-{
-
 #define TINYXML_SAFE_TO_ELEMENT(expr) ((expr) ? (expr)->ToElement() : nullptr)
 
+static void matrixFromXml(ModMatrixConfig &config, TiXmlElement *root)
+{
     auto matrix = TINYXML_SAFE_TO_ELEMENT(root->FirstChild("matrix"));
+    if (!matrix)
+        return;
 
     auto rt = TINYXML_SAFE_TO_ELEMENT(matrix->FirstChild("routing"));
 
@@ -1089,9 +1676,9 @@ bool ConduitPolysynthConfig::PatchExtension::fromXml(TiXmlElement *root)
         rt->QueryIntAttribute("target", &t);
         rt->QueryDoubleAttribute("depth", &d);
 
-        if (idx >= 0)
+        if (idx >= 0 && idx < ModMatrixConfig::nModSlots)
         {
-            auto &rto = modMatrixConfig->routings[idx];
+            auto &rto = config.routings[idx];
             rto.source = (ModMatrixConfig::Sources)s;
             rto.via = (ModMatrixConfig::Sources)v;
             rto.target = (ConduitPolysynth::paramIds)t;
@@ -1100,12 +1687,117 @@ bool ConduitPolysynthConfig::PatchExtension::fromXml(TiXmlElement *root)
 
         rt = rt->NextSiblingElement();
     }
+}
+
+/*
+ * Only the active parts are streamed. Their params are written by id, like the main
+ * patch, so adding parameters doesn't invalidate saved parts.
+ */
+bool ConduitPolysynthConfig::PatchExtension::toXml(TiXmlElement &root)
+{
+    matrixToXml(*modMatrixConfig, root);
+
+    TiXmlElement partsEl("parts");
+    partsEl.SetAttribute("multiTimbral", multiTimbral ? 1 : 0);
+    partsEl.SetAttribute("keying", (int)partKeying);
+    for (int i = 1; i < maxParts; ++i)
+    {
+        const auto &pp = partPatches[i - 1];
+        if (!pp.active)
+            continue;
+
+        TiXmlElement partEl("part");
+        partEl.SetAttribute("idx", i);
+        for (int p = 0; p < nParams; ++p)
+        {
+            TiXmlElement par("param");
+            par.SetAttribute("id", paramIdsByIndex[p]);
+            par.SetDoubleAttribute("value", pp.params[p]);
+            partEl.InsertEndChild(par);
+        }
+        matrixToXml(*pp.modMatrixConfig, partEl);
+        partsEl.InsertEndChild(partEl);
+    }
+    root.InsertEndChild(partsEl);
+
+    return true;
+}
+
+bool ConduitPolysynthConfig::PatchExtension::fromXml(TiXmlElement *root)
+{
+    matrixFromXml(*modMatrixConfig, root);
+
+    multiTimbral = false;
+    partKeying = BY_CHANNEL;
+    for (auto &pp : partPatches)
+        pp.active = false;
+
+    auto partsEl = TINYXML_SAFE_TO_ELEMENT(root->FirstChild("parts"));
+    if (!partsEl)
+        return true;
+
+    int mt{0}, keying{BY_CHANNEL};
+    partsEl->QueryIntAttribute("multiTimbral", &mt);
+    partsEl->QueryIntAttribute("keying", &keying);
+    multiTimbral = mt != 0;
+    partKeying = (keying == BY_PORT) ? BY_PORT : BY_CHANNEL;
+
+    auto partEl = TINYXML_SAFE_TO_ELEMENT(partsEl->FirstChild("part"));
+    while (partEl)
+    {
+        int idx{-1};
+        partEl->QueryIntAttribute("idx", &idx);
+        if (idx > 0 && idx < maxParts)
+        {
+            auto &pp = partPatches[idx - 1];
+
+            // params missing from the stream keep their defaults
+            std::copy(paramDefaultsByIndex.begin(), paramDefaultsByIndex.end(), pp.params);
+            auto par = TINYXML_SAFE_TO_ELEMENT(partEl->FirstChild("param"));
+            while (par)
+            {
+                int id{-1};
+                double value{0};
+                if (par->QueryIntAttribute("id", &id) == TIXML_SUCCESS &&
+                    par->QueryDoubleAttribute("value", &value) == TIXML_SUCCESS)
+                {
+                    auto pos = std::find(paramIdsByIndex.begin(), paramIdsByIndex.end(),
+                                         (clap_id)id);
+                    if (pos != paramIdsByIndex.end())
+                        pp.params[std::distance(paramIdsByIndex.begin(), pos)] = value;
+                }
+                par = TINYXML_SAFE_TO_ELEMENT(par->NextSiblingElement("param"));
+            }
+
+            pp.modMatrixConfig->routings = ModMatrixConfig().routings;
+            matrixFromXml(*pp.modMatrixConfig, partEl);
+            pp.active = true;
+        }
+        partEl = TINYXML_SAFE_TO_ELEMENT(partEl->NextSiblingElement("part"));
+    }
     return true;
 }
 
 void ConduitPolysynth::onStateRestored()
 {
+    for (int i = 0; i < maxParts; ++i)
+        publishMatrix(i);
+    if (matrixSnapshots->reclaim())
+        _host.requestCallback();
+
     uiComms.dataCopyForUI.populateMatrixView(patch.extension.modMatrixConfig);
+    publishPartState();
+    requestPartFXIfMissing();
+
+    if (!isActive())
+    {
+        updateNotePorts();
+    }
+    else if (desiredNotePorts() != advertisedNotePorts)
+    {
+        notePortsDirty = true;
+        _host.requestRestart();
+    }
 }
 
 } // namespace sst::conduit::polysynth
@@ -29,6 +29,7 @@
 #include <optional>
 #include "conduit-shared/debug-helpers.h"
 
+#include <algorithm>
 #include <atomic>
 #include <array>
 #include <unordered_map>
@@ -50,6 +51,8 @@
 #include "sst/effects/Reverb1.h"
 
 #include "conduit-shared/clap-base-class.h"
+#include "conduit-shared/huge-page-arena.h"
+#include "conduit-shared/snapshot-pool.h"
 #include "voice.h"
 
 struct MTSClient;
@@ -60,9 +63,24 @@ namespace sst::conduit::polysynth
  * This static (defined in the cpp file) allows us to present a name, feature set,
  * url etc... and is consumed by clap-saw-demo-pluginentry.cpp
  */
-static constexpr int nParams{72};
+static constexpr int nParams{77};
+
+/*
+ * In multi-timbral mode a single instance holds up to maxParts patches, selected by
+ * the midi channel or note port of the incoming note. Part 0 is the patch the host
+ * sees as parameters; the other parts are snapshots stored in the patch extension.
+ */
+static constexpr int maxParts{16};
 
 struct ModMatrixConfig;
+struct ModMatrixRoutings;
+
+/*
+ * Voices read the mod matrix through immutable snapshots which are swapped in atomically
+ * on edit and reclaimed on the main thread, rather than pointing into the live patch.
+ */
+using MatrixSnapshot = sst::conduit::shared::Snapshot<ModMatrixRoutings>;
+using MatrixSnapshotPool = sst::conduit::shared::SnapshotPool<ModMatrixRoutings, 4 * maxParts>;
 
 struct ConduitPolysynthConfig
 {
@@ -70,6 +88,7 @@ struct ConduitPolysynthConfig
     static constexpr bool baseClassProvidesMonoModSupport{
         false}; // as a synth we do voice level modulation with the VM
     static constexpr bool usesSpecializedMessages{true};
+    static constexpr bool primeOnActivate{false};
     struct PatchExtension
     {
         static constexpr bool hasExtension{true};
@@ -81,6 +100,27 @@ struct ConduitPolysynthConfig
         bool fromXml(TiXmlElement *);
 
         bool mpeMode{false};
+
+        enum PartKeying
+        {
+            BY_CHANNEL = 0,
+            BY_PORT = 1
+        };
+        bool multiTimbral{false};
+        PartKeying partKeying{BY_CHANNEL};
+
+        struct PartPatch
+        {
+            bool active{false};
+            float params[nParams]{};
+            std::unique_ptr<ModMatrixConfig> modMatrixConfig;
+        };
+        // parts 1...maxParts-1; part 0 is the main patch
+        std::array<PartPatch, maxParts - 1> partPatches;
+
+        // set by the plugin once params are configured so parts stream by id, not index
+        std::array<clap_id, nParams> paramIdsByIndex{};
+        std::array<float, nParams> paramDefaultsByIndex{};
     };
     struct DataCopyForUI
     {
@@ -103,6 +143,10 @@ struct ConduitPolysynthConfig
 
         std::atomic<uint16_t> tsig_num, tsig_denom;
 
+        std::atomic<bool> multiTimbral{false};
+        std::atomic<uint32_t> activePartMask{1};
+        std::atomic<int32_t> partKeying{0};
+
         void populateMatrixView(const std::unique_ptr<ModMatrixConfig> &);
     };
 
@@ -121,7 +165,21 @@ struct ConduitPolysynthConfig
             bool active;
             int range{24};
         };
-        std::variant<ModRowMessage, MPEConfig> payload;
+        struct MultiTimbralConfig
+        {
+            bool active;
+            int32_t keying{0};
+        };
+        struct PartCommand
+        {
+            enum Command
+            {
+                COPY_MAIN_TO_PART,
+                CLEAR_PART
+            } command;
+            int32_t part;
+        };
+        std::variant<ModRowMessage, MPEConfig, MultiTimbralConfig, PartCommand> payload;
     };
     using specializedMessage_t = SpecializedMessage;
 };
@@ -137,12 +195,30 @@ using ReverbFX = sst::effects::reverb1::Reverb1<Reverb1Config>;
 struct ConduitPolysynth
     : sst::conduit::shared::ClapBaseClass<ConduitPolysynth, ConduitPolysynthConfig>
 {
-    static constexpr int max_voices = 64;
+    /*
+     * Polyphony is a (non-automatable) parameter, applied at activate, so the voice storage
+     * is sized to what the patch needs rather than to the maximum.
+     */
+    static constexpr int max_voices = 256;
+    static constexpr int default_voices = 64;
     ConduitPolysynth(const clap_host *host);
     ~ConduitPolysynth();
 
     bool activate(double sampleRate, uint32_t minFrameCount,
                   uint32_t maxFrameCount) noexcept override;
+    void deactivate() noexcept override;
+    void onMainThread() noexcept override;
+
+    // The voice pool, with each voice's filter delay buffers, and the parts' FX state
+    template <typename F> void forEachWarmUpRegion(F &&f)
+    {
+        f(voices.begin(), voices.size() * sizeof(PolysynthVoice));
+        for (auto &pt : parts)
+        {
+            if (pt.fx)
+                f(pt.fx.get(), sizeof(PartFX));
+        }
+    }
 
     enum paramIds : uint32_t
     {
@@ -154,6 +230,7 @@ struct ConduitPolysynth
         pmSawCoarse,
         pmSawFine,
         pmSawLevel,
+        pmSawOscMode,
 
         // Pulse Oscillator
         pmPWActive = 1200,
@@ -162,6 +239,7 @@ struct ConduitPolysynth
         pmPWCoarse,
         pmPWFine,
         pmPWLevel,
+        pmPWOscMode,
 
         // Sine Oscillator
         pmSinActive = 1300,
@@ -191,6 +269,7 @@ struct ConduitPolysynth
         pmWSDrive,
         pmWSBias,
         pmWSMode,
+        pmWSTableMode,
 
         pmFilterRouting = 2300,
         pmFilterFeedback,
@@ -231,9 +310,11 @@ struct ConduitPolysynth
         pmRevFXPreset,
         pmRevFXTime,
         pmRevFXMix,
+        pmRevFXRate,
 
         // and finally the main level
         pmOutputLevel = 20100,
+        pmPolyphony,
 
         // Special parameter indicating no modulation target
         pmNoModTarget = 0x0100BEEF
@@ -255,10 +336,23 @@ struct ConduitPolysynth
                         clap_audio_port_info *info) const noexcept override;
 
     bool implementsNotePorts() const noexcept override { return true; }
-    uint32_t notePortsCount(bool isInput) const noexcept override { return isInput ? 1 : 0; }
+    uint32_t notePortsCount(bool isInput) const noexcept override
+    {
+        return isInput ? advertisedNotePorts : 0;
+    }
     bool notePortsInfo(uint32_t index, bool isInput,
                        clap_note_port_info *info) const noexcept override;
 
+    /*
+     * Multi-timbral parts keyed by port get one note port each. Since the port count can
+     * only change while deactivated we keep the advertised count separate from the patch
+     * and request a restart when they differ.
+     */
+    uint32_t advertisedNotePorts{1};
+    bool notePortsDirty{false};
+    uint32_t desiredNotePorts() const;
+    void updateNotePorts();
+
     /*
      * VoiceInfo is an optional (currently draft) extension where you advertise
      * polyphony information. Crucially here though it allows you to advertise that
@@ -269,7 +363,7 @@ struct ConduitPolysynth
     bool voiceInfoGet(clap_voice_info *info) noexcept override
     {
         info->voice_capacity = max_voices;
-        info->voice_count = max_voices;
+        info->voice_count = voiceLimit;
         info->flags = CLAP_VOICE_INFO_SUPPORTS_OVERLAPPING_NOTES;
         return true;
     }
@@ -283,8 +377,29 @@ struct ConduitPolysynth
     clap_process_status process(const clap_process *process) noexcept override;
     void handleInboundEvent(const clap_event_header_t *evt);
     void pushParamsToVoices();
-    void activateVoice(PolysynthVoice &v, int port_index, int channel, int key, int noteid,
-                       double velocity);
+    void activateVoice(PolysynthVoice &v, int part, int port_index, int channel, int key,
+                       int noteid, double velocity);
+
+    /*
+     * Part selection for multi-timbral mode. Notes on a channel (or port) with no
+     * active part patch fall back to part 0.
+     */
+    int partFor(int port, int channel) const;
+    float partParamValue(int part, clap_id id) const
+    {
+        assert(id <= maxParamId && patchIndexById[id] != noPatchIndex);
+        return parts[part].params[patchIndexById[id]];
+    }
+
+    /*
+     * Patch index by param id, built with the params so the per block reads above are a
+     * single load rather than a hash lookup on the audio thread.
+     */
+    static constexpr clap_id maxParamId{pmPolyphony};
+    static constexpr uint8_t noPatchIndex{0xFF};
+    static_assert(nParams < noPatchIndex);
+    std::array<uint8_t, maxParamId + 1> patchIndexById;
+    std::array<float, nParams> paramRangeByIndex{};
 
     /*
      * In addition to ::process, the plugin should implement ::paramsFlush. ::paramsFlush will be
@@ -316,6 +431,18 @@ struct ConduitPolysynth
     std::default_random_engine gen;
     std::uniform_real_distribution<float> urd;
 
+    /*
+     * The reverb can run at a half or a quarter of the host rate behind the same half rate
+     * filters the voices use, which is where most of its cost goes at 96k and up. Reverb1
+     * sees the reduced rate through its config. The divisor comes from the Reverb Rate
+     * parameter and is only applied at activate, since it sets our latency.
+     */
+    static constexpr int maxReverbDivisor{4};
+    int reverbDivisor{1};
+
+    bool implementsLatency() const noexcept override { return true; }
+    uint32_t latencyGet() const noexcept override;
+
     void onStateRestored() override;
 
   protected:
@@ -329,8 +456,87 @@ struct ConduitPolysynth
     uint16_t blockPos{0};
     void renderVoices();
     float output alignas(16)[2][PolysynthVoice::blockSize];
-    float outputOS alignas(16)[2][PolysynthVoice::blockSizeOS];
-    sst::filters::HalfRate::HalfRateFilter hr_dn;
+
+    /*
+     * A part's FX chains and reduced rate reverb state. Only the parts which can play get
+     * one, made in activate on the main thread, so an instance playing a single part does
+     * not carry fifteen idle reverbs.
+     */
+    struct PartFX
+    {
+        PartFX(ConduitPolysynth *synth, int part);
+        void reset(); // after a sample rate change
+
+        PhaserFX phaser;
+        FlangerFX flanger;
+        ReverbFX reverb;
+
+        /*
+         * Below the host rate the part output is gathered for reverbDivisor blocks and
+         * decimated into one reverb block. The upsampled wet is then mixed with that same
+         * dry over the following reverbDivisor blocks, so the part runs that many late.
+         */
+        static constexpr int revBufferSize{PolysynthVoice::blockSize * maxReverbDivisor};
+        float revIn alignas(16)[2][revBufferSize];
+        float revWet alignas(16)[2][revBufferSize];
+        float revMix{0.f};
+        int revPos{0};
+        sst::filters::HalfRate::HalfRateFilter rev_dn1{6, true}, rev_dn2{6, true};
+        sst::filters::HalfRate::HalfRateFilter rev_up1{6, true}, rev_up2{6, true};
+    };
+
+    /*
+     * Each part renders its voices into its own oversampled buffer, downsamples, runs its
+     * own FX chain and then sums into the output. A part only costs cpu once it has
+     * been used since activation, so the single timbral case is unchanged.
+     */
+    struct Part
+    {
+        float *params{nullptr};
+        ModMatrixConfig *modMatrix{nullptr};
+        std::atomic<const MatrixSnapshot *> matrix{nullptr};
+
+        std::unique_ptr<PartFX> fx;
+
+        bool used{false};
+        PatchUniforms uniforms;
+        float output alignas(16)[2][PolysynthVoice::blockSize];
+        float outputOS alignas(16)[2][PolysynthVoice::blockSizeOS];
+        sst::filters::HalfRate::HalfRateFilter hr_dn{6, true};
+    };
+    std::array<Part, maxParts> parts;
+    void bindParts();
+
+    /*
+     * Whether a part can be picked for notes and so needs its FX. A part enabled while we
+     * are active plays as part 0 until the restart this requests has made its FX.
+     */
+    bool partWantsFX(int part) const;
+    void requestPartFXIfMissing();
+    bool partFXRestartRequested{false};
+    void updatePartUniforms(int part);
+    void processReducedRateReverb(int part);
+
+    /*
+     * publishMatrix snapshots a part's matrix from the patch and may run on either thread.
+     * If the pool is exhausted the part is marked dirty and the audio thread retries at
+     * the top of the next block, after the main thread has had a chance to reclaim.
+     */
+    std::unique_ptr<MatrixSnapshotPool> matrixSnapshots;
+    std::atomic<uint32_t> matrixDirtyMask{0};
+    bool publishMatrix(int part);
+    void publishDirtyMatrices();
+    void publishPartState();
+
+    /*
+     * When voiceLimit voices are held, a new note steals the oldest released voice, else the
+     * oldest voice, which fades out while the new note starts in one of stealHeadroom spare
+     * voices. Only if those are all fading too is the one closest to silence cut.
+     */
+    static constexpr size_t stealHeadroom{8};
+    void stealVoice();
+    PolysynthVoice *reclaimFadingVoice();
+    uint64_t voiceStartCounter{0};
 
     // Voice Management
     struct VMConfig
@@ -367,19 +573,14 @@ struct ConduitPolysynth
         CNDOUT << "retriggerVoice" << std::endl;
     }
 
-    void setVoiceMIDIPitchBend(PolysynthVoice *v, uint16_t pb14bit)
-    {
-        auto bv = (pb14bit - 8192) / 8192.f;
-        v->pitchBendWheel = bv * 2; // just hardcode a pitch bend depth of 2
-        v->recalcPitch();
-    }
-
-    void setVoiceMIDIMPEChannelPitchBend(PolysynthVoice *v, uint16_t pb14bit)
-    {
-        auto bv = (pb14bit - 8192) / 8192.f;
-        v->mpePitchBend = bv;
-        v->recalcPitch();
-    }
+    /*
+     * Channel wide MIDI (CCs, channel pressure, pitch bend) is stored once per port and
+     * channel by updateChannelControllers before the voice manager sees the message, and
+     * voices read it from there. The voice manager only gets the CCs it acts on itself, so
+     * these responders which would fan the message out to each voice do nothing.
+     */
+    void setVoiceMIDIPitchBend(PolysynthVoice *v, uint16_t pb14bit) {}
+    void setVoiceMIDIMPEChannelPitchBend(PolysynthVoice *v, uint16_t pb14bit) {}
 
     void setVoicePolyphonicParameterModulation(PolysynthVoice *v, uint32_t parameter, double value)
     {
@@ -396,9 +597,16 @@ struct ConduitPolysynth
         v->applyPolyphonicAftertouch(pat);
     }
 
-    void setChannelPressure(PolysynthVoice *v, int8_t pres) { v->applyChannelPressure(pres); }
+    void setChannelPressure(PolysynthVoice *v, int8_t pres) {}
+    void setMIDI1CC(PolysynthVoice *v, int8_t cc, int8_t val) {}
 
-    void setMIDI1CC(PolysynthVoice *v, int8_t cc, int8_t val) { v->applyMIDI1CC(cc, val); }
+    static constexpr int mpeGlobalChannel{0};
+    const ChannelControllers &channelControllersFor(int port, int channel) const
+    {
+        return channelControllers[std::clamp(port, 0, maxParts - 1)][channel & 15];
+    }
+    // nullptr unless we are in MPE mode and the channel is a member channel
+    const ChannelControllers *mpeGlobalControllersFor(int port, int channel) const;
 
     void handleSpecializedFromUI(const FromUI &r);
 
@@ -407,18 +615,33 @@ struct ConduitPolysynth
 
     MTSClient *mtsClient{nullptr};
 
-    std::unique_ptr<PhaserFX> phaserFX;
-    std::unique_ptr<FlangerFX> flangerFX;
-    std::unique_ptr<ReverbFX> reverbFX;
-
     sst::basic_blocks::dsp::VUPeak mainVU;
 
   private:
     using voiceManager_t = sst::voicemanager::VoiceManager<VMConfig, ConduitPolysynth>;
     voiceManager_t voiceManager;
 
-    std::array<PolysynthVoice, max_voices> voices;
+    // allocated in activate with *polyphony voices plus the steal headroom; big enough to want
+    // huge pages
+    sst::conduit::shared::HugePageArena<PolysynthVoice> voices;
+    size_t voiceLimit{0};
+    void allocateVoices(size_t count);
+    float *polyphonyParam{nullptr};
+    size_t requestedPolyphony() const;
+    bool polyphonyRestartRequested{false};
+    float *reverbRateParam{nullptr};
+    int requestedReverbDivisor() const;
+    bool reverbRestartRequested{false};
+
     std::vector<std::tuple<int, int, int, int>> terminatedVoices; // that's PCK ID
+
+    // The voices renderVoices is running this block, gathered once so the modulator and
+    // audio passes see the same set even if an envelope finishes in between
+    std::array<PolysynthVoice *, max_voices + stealHeadroom> playingVoices{};
+
+    std::array<std::array<ChannelControllers, 16>, maxParts> channelControllers{};
+    // returns true if the message is fully consumed and need not go to the voice manager
+    bool updateChannelControllers(uint16_t port, const uint8_t *data);
 };
 
 struct ModMatrixConfig
@@ -479,6 +702,14 @@ struct ModMatrixConfig
         }
     }
 };
+
+// The part of a ModMatrixConfig which voices read, copied into each matrix snapshot
+struct ModMatrixRoutings
+{
+    std::array<ModMatrixConfig::EntryDescription, ModMatrixConfig::nModSlots> routings{};
+    // Each routing's target range, resolved at publish so voices bind without a lookup
+    std::array<float, ModMatrixConfig::nModSlots> targetRanges{};
+};
 } // namespace sst::conduit::polysynth
 
 #endif
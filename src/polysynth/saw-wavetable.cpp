@@ -0,0 +1,111 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#include "saw-wavetable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace sst::conduit::polysynth
+{
+const SawWavetable &SawWavetable::get()
+{
+    static SawWavetable instance;
+    return instance;
+}
+
+/*
+ * saw(p) = 2p - 1 = -(2/pi) sum_h sin(2 pi h p) / h. We build from the narrowest level
+ * up, adding only the new harmonics to a copy of the level above, and step each harmonic
+ * across the table with a rotation rather than calling sin per point. That keeps the
+ * whole build to about two million complex multiplies.
+ */
+SawWavetable::SawWavetable()
+{
+    std::vector<double> acc(tableSize, 0.0);
+
+    int harmonicsDone{0};
+    for (int l = nLevels - 1; l >= 0; --l)
+    {
+        int harmonics = (tableSize / 2) >> l;
+        for (int h = harmonicsDone + 1; h <= harmonics; ++h)
+        {
+            auto w = 2.0 * M_PI * h / tableSize;
+            auto cw = std::cos(w), sw = std::sin(w);
+            double c{1.0}, s{0.0};
+            auto amp = -2.0 / (M_PI * h);
+            for (int i = 0; i < tableSize; ++i)
+            {
+                acc[i] += amp * s;
+                auto nc = c * cw - s * sw;
+                s = s * cw + c * sw;
+                c = nc;
+            }
+        }
+        harmonicsDone = harmonics;
+
+        for (int i = 0; i < tableSize; ++i)
+            data[l][i] = (float)acc[i];
+        data[l][tableSize] = data[l][0];
+    }
+}
+
+void WavetableSawUnison::setUnison(int n, const float *panL, const float *panR,
+                                   const float *levelNorm)
+{
+    count = std::clamp(n, 1, maxUnison);
+    for (int i = 0; i < maxUnison; ++i)
+    {
+        if (i < count)
+        {
+            gainL[i] = panL[i] * levelNorm[i];
+            gainR[i] = panR[i] * levelNorm[i];
+        }
+        else
+        {
+            gainL[i] = 0.f;
+            gainR[i] = 0.f;
+            increments[i] = 0.f;
+        }
+    }
+}
+
+void WavetableSawUnison::retrigger()
+{
+    for (auto &p : phases)
+        p = 0.f;
+}
+
+void WavetableSawUnison::updateLevel()
+{
+    float mx{0.f};
+    for (int i = 0; i < count; ++i)
+        mx = std::max(mx, std::fabs(increments[i]));
+    table = SawWavetable::get().data[SawWavetable::levelFor(mx)];
+}
+
+void WavetablePulse::setPhaseIncrement(float dPhase)
+{
+    increment = dPhase;
+    level = SawWavetable::levelFor(std::fabs(dPhase));
+}
+} // namespace sst::conduit::polysynth
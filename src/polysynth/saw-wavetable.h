@@ -0,0 +1,182 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_SRC_POLYSYNTH_SAW_WAVETABLE_H
+#define CONDUIT_SRC_POLYSYNTH_SAW_WAVETABLE_H
+
+#include <cstdint>
+
+#include "conduit-shared/sse-include.h"
+
+namespace sst::conduit::polysynth
+{
+/*
+ * A band limited saw, built additively as one table per octave. Mip level l holds
+ * the first (tableSize / 2) >> l harmonics, and an oscillator reads the lowest level
+ * whose top harmonic stays under nyquist at its phase increment, so nothing aliases.
+ * The table is shared by every voice and built on first use of get(), which the synth
+ * calls from its constructor.
+ */
+struct SawWavetable
+{
+    static constexpr int tableBits{11};
+    static constexpr int tableSize{1 << tableBits};
+    static constexpr int nLevels{tableBits};
+
+    // one guard point per level so interpolation never wraps
+    float data alignas(16)[nLevels][tableSize + 1];
+
+    static const SawWavetable &get();
+
+    static int levelFor(float phaseIncrement)
+    {
+        int l{0};
+        float harmonics = tableSize / 2;
+        while (l < nLevels - 1 && harmonics * phaseIncrement > 0.5f)
+        {
+            harmonics *= 0.5f;
+            l++;
+        }
+        return l;
+    }
+
+    // scalar, linearly interpolated read at phase in [0,1)
+    inline float read(int level, float phase) const
+    {
+        auto x = phase * tableSize;
+        auto xi = (int)x;
+        auto frac = x - xi;
+        const auto *t = data[level];
+        return t[xi] + frac * (t[xi + 1] - t[xi]);
+    }
+
+  private:
+    SawWavetable();
+};
+
+/*
+ * Up to 8 unison saws read from the wavetable with two SSE phase accumulators. All lanes
+ * share the mip level of the fastest lane, which keeps each sample to one table and is
+ * at worst a few cents conservative on the band limit.
+ */
+struct WavetableSawUnison
+{
+    static constexpr int maxUnison{8};
+
+    void setUnison(int count, const float *panL, const float *panR, const float *levelNorm);
+    void setPhaseIncrement(int idx, float dPhase) { increments[idx] = dPhase; }
+    void retrigger();
+
+    // Called after the phase increments change, to pick the mip level
+    void updateLevel();
+
+    // Writes (not accumulates) the unison sum as (L, R, 0, 0) frames
+    template <int N> void processBlock(__m128 *frames);
+
+  private:
+    float phases alignas(16)[maxUnison]{};
+    float increments alignas(16)[maxUnison]{};
+    float gainL alignas(16)[maxUnison]{};
+    float gainR alignas(16)[maxUnison]{};
+    int count{1};
+    const float *table{nullptr};
+};
+
+/*
+ * A pulse as the difference of two band limited saws a width apart, so it inherits
+ * their band limit.
+ */
+struct WavetablePulse
+{
+    void setPhaseIncrement(float dPhase);
+    void setPulseWidth(float w) { width = w; }
+    void retrigger() { phase = 0.f; }
+
+    inline float step()
+    {
+        phase += increment;
+        phase -= (int)phase;
+        auto p2 = phase + width;
+        p2 -= (int)p2;
+        return 0.5f * (wt->read(level, phase) - wt->read(level, p2));
+    }
+
+  private:
+    const SawWavetable *wt{&SawWavetable::get()};
+    float phase{0.f}, increment{0.f}, width{0.5f};
+    int level{0};
+};
+
+template <int N> void WavetableSawUnison::processBlock(__m128 *frames)
+{
+    static constexpr float tsz{SawWavetable::tableSize};
+
+    __m128 ph[2], dp[2], gl[2], gr[2];
+    for (int v = 0; v < 2; ++v)
+    {
+        ph[v] = _mm_load_ps(phases + 4 * v);
+        dp[v] = _mm_load_ps(increments + 4 * v);
+        gl[v] = _mm_load_ps(gainL + 4 * v);
+        gr[v] = _mm_load_ps(gainR + 4 * v);
+    }
+    // unison of four or fewer only needs the first register
+    const int nv = count > 4 ? 2 : 1;
+    const auto *t = table;
+
+    for (int s = 0; s < N; ++s)
+    {
+        auto accL = _mm_setzero_ps();
+        auto accR = _mm_setzero_ps();
+        for (int v = 0; v < nv; ++v)
+        {
+            // phases are non-negative so truncation is floor
+            auto p = _mm_add_ps(ph[v], dp[v]);
+            p = _mm_sub_ps(p, _mm_cvtepi32_ps(_mm_cvttps_epi32(p)));
+            ph[v] = p;
+
+            auto x = _mm_mul_ps(p, _mm_set1_ps(tsz));
+            auto xi = _mm_cvttps_epi32(x);
+            auto frac = _mm_sub_ps(x, _mm_cvtepi32_ps(xi));
+
+            int idx alignas(16)[4];
+            _mm_store_si128((__m128i *)idx, xi);
+            auto lo = _mm_set_ps(t[idx[3]], t[idx[2]], t[idx[1]], t[idx[0]]);
+            auto hi = _mm_set_ps(t[idx[3] + 1], t[idx[2] + 1], t[idx[1] + 1], t[idx[0] + 1]);
+            auto out = _mm_add_ps(lo, _mm_mul_ps(frac, _mm_sub_ps(hi, lo)));
+
+            accL = _mm_add_ps(accL, _mm_mul_ps(out, gl[v]));
+            accR = _mm_add_ps(accR, _mm_mul_ps(out, gr[v]));
+        }
+
+        // horizontal sums of both accumulators at once, landing in lanes 0 and 1
+        auto sum = _mm_add_ps(_mm_unpacklo_ps(accL, accR), _mm_unpackhi_ps(accL, accR));
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        frames[s] = _mm_movelh_ps(sum, _mm_setzero_ps());
+    }
+
+    for (int v = 0; v < 2; ++v)
+    {
+        _mm_store_ps(phases + 4 * v, ph[v]);
+    }
+}
+} // namespace sst::conduit::polysynth
+
+#endif // CONDUIT_SRC_POLYSYNTH_SAW_WAVETABLE_H
@@ -21,6 +21,8 @@
 
 #include "voice.h"
 #include "polysynth.h"
+#include "modulator-bank.h"
+#include "waveshaper-tables.h"
 #include <cmath>
 #include <algorithm>
 
@@ -61,8 +63,13 @@ void PolysynthVoice::recalcPitch()
                     ((sawUnisonDetune.value() * sawUniVoiceDetune[i] + sawFine.value()) / 100 +
                      sawCoarse.value() + coarseBend) /
                     12.0);
-            sawOsc[i].setFrequency(uf, srInv);
+            if (sawUseWavetable)
+                sawWavetable.setPhaseIncrement(i, uf * srInv);
+            else
+                sawOsc[i].setFrequency(uf, srInv);
         }
+        if (sawUseWavetable)
+            sawWavetable.updateLevel();
     }
 
     static constexpr float mul[7] = {0.125, 0.25, 0.5, 1, 2, 4, 8};
@@ -73,8 +80,16 @@ void PolysynthVoice::recalcPitch()
         auto sbf = baseFreq * mul[po];
         auto pf = sbf * synth.twoToXTable.twoToThe(
                             (pulseCoarse.value() + pulseFine.value() * 0.01 + coarseBend) / 12.0);
-        pulseOsc.setFrequency(pf, srInv);
-        pulseOsc.setPulseWidth(pulseWidth.value());
+        if (pulseUseWavetable)
+        {
+            pulseWavetable.setPhaseIncrement(pf * srInv);
+            pulseWavetable.setPulseWidth(std::clamp(pulseWidth.value(), 0.f, 1.f));
+        }
+        else
+        {
+            pulseOsc.setFrequency(pf, srInv);
+            pulseOsc.setPulseWidth(pulseWidth.value());
+        }
     }
 
     if (sinActive)
@@ -92,7 +107,7 @@ void PolysynthVoice::recalcFilter()
     {
         auto co = svfCutoff.value();
         auto rm = svfResonance.value();
-        svfImpl.setCoeff(co, rm, srInv);
+        svfImpl.setCoeff(synth.noteToFrequency(co), rm, srInv);
     }
 
     if (lpfActive)
@@ -105,22 +120,133 @@ void PolysynthVoice::recalcFilter()
     }
 }
 
-static __m128 wsNoOp(sst::waveshapers::QuadWaveshaperState *__restrict, __m128 in, __m128 drive)
+/*
+ * One pass over the block's frames: pre filter gain, the filter chain in the given routing
+ * order with feedback, and the AEG. The frame stays in a register for the whole chain and
+ * the feedback signal is carried in a local across samples. Stages not in the stages mask
+ * are the identity at compile time.
+ */
+template <int routing, int stages> void PolysynthVoice::processFrames(const FrameRamps &ramps)
 {
-    return in;
+    auto fbSignal = filterFeedbackSignal;
+    const auto half = _mm_set1_ps(0.5f);
+
+    constexpr bool doLPF = stages & stageLPF;
+    constexpr bool doWS = stages & stageWS;
+    constexpr bool doSVF = stages & stageSVF;
+
+    auto lpf = [this](auto x) {
+        if constexpr (doLPF)
+            return qfPtr(&qfState, x);
+        else
+            return x;
+    };
+    auto svf = [this](auto x) {
+        if constexpr (doSVF)
+            return svfFilterOp(svfImpl, x);
+        else
+            return x;
+    };
+    auto ws = [this](auto x, auto bias, auto drive) {
+        if constexpr (doWS)
+            return wsPtr(&wsState, _mm_add_ps(x, bias), drive);
+        else
+            return x;
+    };
+    // An inactive side of the parallel pair passes dry, so with both off the mix is x
+    auto par = [&](auto x) {
+        if constexpr (!doLPF && !doSVF)
+            return x;
+        else
+            return _mm_mul_ps(half, _mm_add_ps(lpf(x), svf(x)));
+    };
+
+    for (auto s = 0U; s < blockSizeOS; ++s)
+    {
+        auto output = _mm_mul_ps(frames[s], ramps.pfg[s]);
+
+        if constexpr (routing != noFilterRouting)
+        {
+            output = _mm_add_ps(output, fbSignal);
+            const auto drive = ramps.drive[s];
+            const auto bias = ramps.bias[s];
+
+            if constexpr (routing == LowWSMulti)
+            {
+                output = svf(ws(lpf(output), bias, drive));
+            }
+            else if constexpr (routing == MultiWSLow)
+            {
+                output = lpf(ws(svf(output), bias, drive));
+            }
+            else if constexpr (routing == WSLowMulti)
+            {
+                output = svf(lpf(ws(output, bias, drive)));
+            }
+            else if constexpr (routing == LowMultiWS)
+            {
+                output = ws(svf(lpf(output)), bias, drive);
+            }
+            else if constexpr (routing == WSPar)
+            {
+                output = par(ws(output, bias, drive));
+            }
+            else if constexpr (routing == ParWS)
+            {
+                output = ws(par(output), bias, drive);
+            }
+
+            fbSignal = _mm_mul_ps(output, ramps.fback[s]);
+        }
+
+        frames[s] = _mm_mul_ps(output, _mm_load1_ps(aeg.outputCache + s));
+    }
+
+    filterFeedbackSignal = fbSignal;
 }
 
-static __m128 qfNoOp(sst::filters::QuadFilterUnitState *__restrict, __m128 in) { return in; }
+template <int routing> void PolysynthVoice::dispatchFilterStages(const FrameRamps &ramps)
+{
+    switch (filterStages)
+    {
+    case 1:
+        processFrames<routing, 1>(ramps);
+        break;
+    case 2:
+        processFrames<routing, 2>(ramps);
+        break;
+    case 3:
+        processFrames<routing, 3>(ramps);
+        break;
+    case 4:
+        processFrames<routing, 4>(ramps);
+        break;
+    case 5:
+        processFrames<routing, 5>(ramps);
+        break;
+    case 6:
+        processFrames<routing, 6>(ramps);
+        break;
+    case 7:
+        processFrames<routing, 7>(ramps);
+        break;
+    }
+}
+
+float PolysynthVoice::envelope_rate_linear_nowrap(float f)
+{
+    return synth.envelopeRateLinear(f, blockSizeOS, srInv);
+}
 
 void PolysynthVoice::processBlock()
 {
     static constexpr float vScale{0.2};
-    aeg.processBlock(aegValues.attack.value(), aegValues.decay.value(), aegValues.sustain.value(),
-                     aegValues.release.value(), 0, 0, 0, gated);
-    feg.processBlock(fegValues.attack.value(), fegValues.decay.value(), fegValues.sustain.value(),
-                     fegValues.release.value(), 0, 0, 0, gated);
-    lfos[0].process_block(lfoData[0].rate.value(), lfoData[0].deform.value(), lfoData[0].shape);
-    lfos[1].process_block(lfoData[1].rate.value(), lfoData[1].deform.value(), lfoData[1].shape);
+    if (synth.parts[part].matrix.load()->version != boundMatrixVersion)
+        bindMatrix();
+
+    if (channelControls->version != channelControlsVersion ||
+        (mpeGlobalControls && mpeGlobalControls->version != mpeGlobalControlsVersion))
+        syncChannelControls(false);
 
     *svfCutoff.internalMod = 0;
     *lpfCutoff.internalMod = 0;
@@ -148,16 +274,30 @@ void PolysynthVoice::processBlock()
     recalcFilter();
     recalcPitch();
 
-    memset(outputOS, 0, sizeof(outputOS));
+    for (auto &f : frames)
+        f = _mm_setzero_ps();
 
-    if (sawActive)
+    if (sawActive && sawUseWavetable)
+    {
+        sawLevel_lipol.newValue(sawLevel.isUnmodulated() ? uniforms->sawLevelCubed
+                                                         : cubed(sawLevel.value()));
+        __m128 sawFrames[blockSizeOS];
+        sawWavetable.processBlock<blockSizeOS>(sawFrames);
+        for (auto s = 0U; s < blockSizeOS; ++s)
+        {
+            auto sl = _mm_set1_ps(vScale * sawLevel_lipol.v);
+            frames[s] = _mm_add_ps(frames[s], _mm_mul_ps(sl, sawFrames[s]));
+            sawLevel_lipol.process();
+        }
+    }
+    else if (sawActive)
     {
-        sawLevel_lipol.newValue(sawLevel.value());
+        sawLevel_lipol.newValue(sawLevel.isUnmodulated() ? uniforms->sawLevelCubed
+                                                         : cubed(sawLevel.value()));
         for (auto s = 0U; s < blockSizeOS; ++s)
         {
             float L{0}, R{0};
             auto sl = sawLevel_lipol.v;
-            sl = sl * sl * sl;
             for (int i = 0; i < sawUnison; ++i)
             {
                 auto out = sawOsc[i].step();
@@ -165,176 +305,148 @@ void PolysynthVoice::processBlock()
                 R += vScale * sl * sawUniLevelNorm[i] * sawUniPanR[i] * out;
             }
 
-            outputOS[0][s] += L;
-            outputOS[1][s] += R;
+            frames[s] = _mm_add_ps(frames[s], _mm_set_ps(0, 0, R, L));
             sawLevel_lipol.process();
         }
     }
 
     if (pulseActive)
     {
-        pulseLevel_lipol.newValue(pulseLevel.value());
+        pulseLevel_lipol.newValue(pulseLevel.isUnmodulated() ? uniforms->pulseLevelCubed
+                                                             : cubed(pulseLevel.value()));
         for (auto s = 0U; s < blockSizeOS; ++s)
         {
             auto sl = pulseLevel_lipol.v;
-            sl = sl * sl * sl;
-            auto V = vScale * sl * pulseOsc.step();
+            auto V = vScale * sl * (pulseUseWavetable ? pulseWavetable.step() : pulseOsc.step());
 
-            outputOS[0][s] += V;
-            outputOS[1][s] += V;
+            frames[s] = _mm_add_ps(frames[s], monoFrame(V));
             pulseLevel_lipol.process();
         }
     }
 
     if (sinActive)
     {
-        sinLevel_lipol.newValue(sinLevel.value());
+        sinLevel_lipol.newValue(sinLevel.isUnmodulated() ? uniforms->sinLevelCubed
+                                                         : cubed(sinLevel.value()));
         for (auto s = 0U; s < blockSizeOS; ++s)
         {
             sinOsc.step();
             auto sl = sinLevel_lipol.v;
-            sl = sl * sl * sl;
             auto V = vScale * sl * sinOsc.u;
 
-            outputOS[0][s] += V;
-            outputOS[1][s] += V;
+            frames[s] = _mm_add_ps(frames[s], monoFrame(V));
             sinLevel_lipol.process();
         }
     }
 
     if (noiseActive)
     {
-        noiseLevel_lipol.newValue(noiseLevel.value());
+        noiseLevel_lipol.newValue(noiseLevel.isUnmodulated() ? uniforms->noiseLevelCubed
+                                                             : cubed(noiseLevel.value()));
         for (auto s = 0U; s < blockSizeOS; ++s)
         {
             auto sl = noiseLevel_lipol.v;
-            sl = sl * sl * sl;
-
             auto V = vScale * sl *
                      sst::basic_blocks::dsp::correlated_noise_o2mk2_supplied_value(
                          w0, w1, noiseColor.value(), urd(gen));
-            outputOS[0][s] += V;
-            outputOS[1][s] += V;
+            frames[s] = _mm_add_ps(frames[s], monoFrame(V));
 
             noiseLevel_lipol.process();
         }
     }
 
-    // Filter stage
-    aegPFG_lipol.set_target(synth.dbToLinear(aegPFG.value()));
-    aegPFG_lipol.multiply_2_blocks(outputOS[0], outputOS[1]);
+    // Filter stage. The per sample ramps are built up front so the frame loop is just
+    // loads and math on registers.
+    FrameRamps ramps;
+    aegPFG_lipol.newValue(aegPFG.isUnmodulated() ? uniforms->aegPFGLinear
+                                                 : synth.dbToLinear(aegPFG.value()));
+    for (auto s = 0U; s < blockSizeOS; ++s)
+    {
+        ramps.pfg[s] = _mm_set1_ps(aegPFG_lipol.v);
+        aegPFG_lipol.process();
+    }
 
-    wsDrive_lipol.newValue(synth.dbToLinear(wsDrive.value()));
+    wsDrive_lipol.newValue(wsDrive.isUnmodulated() ? uniforms->wsDriveLinear
+                                                   : synth.dbToLinear(wsDrive.value()));
     wsBias_lipol.newValue(wsBias.value() * (wsActive ? 1.f : 0.f));
     filterFeedback_lipol.newValue(filterFeedback.value());
     if (anyFilterStepActive)
     {
-
-#define PACK                                                                                       \
-    auto output = _mm_set_ps(0, 0, outputOS[1][s], outputOS[0][s]);                                \
-    auto drive = _mm_set1_ps(wsDrive_lipol.v);                                                     \
-    wsDrive_lipol.process();                                                                       \
-    auto bias = _mm_set1_ps(wsBias_lipol.v);                                                       \
-    wsBias_lipol.process();                                                                        \
-    auto fback = _mm_set1_ps(filterFeedback_lipol.v);                                              \
-    filterFeedback_lipol.process();                                                                \
-    output = _mm_add_ps(output, filterFeedbackSignal)
-
-#define UNPACK                                                                                     \
-    filterFeedbackSignal = _mm_mul_ps(output, fback);                                              \
-    float outArr alignas(16)[4];                                                                   \
-    _mm_store_ps(outArr, output);                                                                  \
-    outputOS[0][s] = outArr[0];                                                                    \
-    outputOS[1][s] = outArr[1]
+        for (auto s = 0U; s < blockSizeOS; ++s)
+        {
+            ramps.drive[s] = _mm_set1_ps(wsDrive_lipol.v);
+            ramps.bias[s] = _mm_set1_ps(wsBias_lipol.v);
+            ramps.fback[s] = _mm_set1_ps(filterFeedback_lipol.v);
+            wsDrive_lipol.process();
+            wsBias_lipol.process();
+            filterFeedback_lipol.process();
+        }
 
         switch (filterRouting)
         {
         case LowWSMulti:
-            for (auto s = 0U; s < blockSizeOS; ++s)
-            {
-                PACK;
-                output = qfPtr(&qfState, output);
-                output = wsPtr(&wsState, _mm_add_ps(output, bias), drive);
-                output = svfFilterOp(svfImpl, output);
-                UNPACK;
-            }
+            dispatchFilterStages<LowWSMulti>(ramps);
             break;
         case MultiWSLow:
-            for (auto s = 0U; s < blockSizeOS; ++s)
-            {
-                PACK;
-                output = svfFilterOp(svfImpl, output);
-                output = wsPtr(&wsState, _mm_add_ps(output, bias), drive);
-                output = qfPtr(&qfState, output);
-                UNPACK;
-            }
+            dispatchFilterStages<MultiWSLow>(ramps);
             break;
         case WSLowMulti:
-            for (auto s = 0U; s < blockSizeOS; ++s)
-            {
-                PACK;
-                output = wsPtr(&wsState, _mm_add_ps(output, bias), drive);
-                output = qfPtr(&qfState, output);
-                output = svfFilterOp(svfImpl, output);
-                UNPACK;
-            }
+            dispatchFilterStages<WSLowMulti>(ramps);
             break;
         case LowMultiWS:
-            for (auto s = 0U; s < blockSizeOS; ++s)
-            {
-                PACK;
-                output = qfPtr(&qfState, output);
-                output = svfFilterOp(svfImpl, output);
-                output = wsPtr(&wsState, _mm_add_ps(output, bias), drive);
-                UNPACK;
-            }
+            dispatchFilterStages<LowMultiWS>(ramps);
             break;
         case WSPar:
-            for (auto s = 0U; s < blockSizeOS; ++s)
-            {
-                PACK;
-                output = wsPtr(&wsState, _mm_add_ps(output, bias), drive);
-
-                auto outputQ = qfPtr(&qfState, output);
-                auto outputS = svfFilterOp(svfImpl, output);
-                const auto half = _mm_set1_ps(0.5f);
-                output = _mm_mul_ps(half, _mm_add_ps(outputQ, outputS));
-                UNPACK;
-            }
+            dispatchFilterStages<WSPar>(ramps);
             break;
         case ParWS:
-            for (auto s = 0U; s < blockSizeOS; ++s)
-            {
-                PACK;
-                auto outputQ = qfPtr(&qfState, output);
-                auto outputS = svfFilterOp(svfImpl, output);
-                const auto half = _mm_set1_ps(0.5f);
-                output = _mm_mul_ps(half, _mm_add_ps(outputQ, outputS));
-                output = wsPtr(&wsState, _mm_add_ps(output, bias), drive);
-
-                UNPACK;
-            }
+            dispatchFilterStages<ParWS>(ramps);
             break;
         }
     }
-    sst::basic_blocks::mechanics::scale_by<blockSizeOS>(aeg.outputCache, outputOS[0]);
-    sst::basic_blocks::mechanics::scale_by<blockSizeOS>(aeg.outputCache, outputOS[1]);
+    else
+    {
+        processFrames<noFilterRouting>(ramps);
+    }
+
+    // Back to planar for the level, pan and the synth's summing. Four (L, R, 0, 0) frames
+    // transpose into one register of L and one of R.
+    for (auto s = 0U; s < blockSizeOS; s += 4)
+    {
+        auto lr01 = _mm_unpacklo_ps(frames[s], frames[s + 1]);
+        auto lr23 = _mm_unpacklo_ps(frames[s + 2], frames[s + 3]);
+        _mm_store_ps(outputOS[0] + s, _mm_movelh_ps(lr01, lr23));
+        _mm_store_ps(outputOS[1] + s, _mm_movehl_ps(lr23, lr01));
+    }
 
-    auto olv = outputLevel.value();
     auto velSen = velocitySens.value();
     auto velAtten = velocity * velSen + (1 - velSen);
-    olv *= velAtten;
-
-    olv = olv * olv * olv;
+    auto olv = outputLevel.isUnmodulated() ? uniforms->outputLevelCubed
+                                           : cubed(outputLevel.value());
+    olv *= cubed(velAtten);
 
     outputLevel_lipol.set_target(olv);
     outputLevel_lipol.multiply_2_blocks(outputOS[0], outputOS[1]);
 
-    auto opv = outputPan.value();
-    if (opv != 0.f)
+    sst::basic_blocks::dsp::pan_laws::panmatrix_t voicePanMatrix;
+    const float *panMatrix{nullptr};
+    if (outputPan.isUnmodulated())
+    {
+        if (!uniforms->outputPanCentered)
+            panMatrix = uniforms->outputPanMatrix;
+    }
+    else
+    {
+        auto opv = outputPan.value();
+        if (opv != 0.f)
+        {
+            sst::basic_blocks::dsp::pan_laws::stereoTruePanning((opv + 1) * 0.5, voicePanMatrix);
+            panMatrix = voicePanMatrix;
+        }
+    }
+
+    if (panMatrix)
     {
-        sst::basic_blocks::dsp::pan_laws::panmatrix_t panMatrix;
-        sst::basic_blocks::dsp::pan_laws::stereoTruePanning((opv + 1) * 0.5, panMatrix);
         for (auto s = 0U; s < blockSizeOS; ++s)
         {
             auto l = panMatrix[0] * outputOS[0][s] + panMatrix[2] * outputOS[1][s];
@@ -344,6 +456,27 @@ void PolysynthVoice::processBlock()
             outputOS[1][s] = r;
         }
     }
+
+    if (stolen)
+    {
+        // each block takes 1/stealFadeBlocks off the gain, linearly across the block
+        auto g = (float)stealFadeRemaining / stealFadeBlocks;
+        auto dg = 1.f / (stealFadeBlocks * blockSizeOS);
+        for (auto s = 0U; s < blockSizeOS; ++s)
+        {
+            g -= dg;
+            outputOS[0][s] *= g;
+            outputOS[1][s] *= g;
+        }
+        stealFadeRemaining--;
+    }
+}
+
+void PolysynthVoice::beginStealFade()
+{
+    stolen = true;
+    stealFadeBlocks = std::max(1, (int)(stealFadeSeconds * samplerate / blockSizeOS));
+    stealFadeRemaining = stealFadeBlocks;
 }
 
 void PolysynthVoice::start(int16_t porti, int16_t channeli, int16_t keyi, int32_t noteidi,
@@ -355,21 +488,24 @@ void PolysynthVoice::start(int16_t porti, int16_t channeli, int16_t keyi, int32_
     note_id = noteidi;
     velocity = veli;
 
-    pitchBendWheel = 0;
-    mpePitchBend = 0;
+    channelControls = &synth.channelControllersFor(porti, channeli);
+    mpeGlobalControls = synth.mpeGlobalControllersFor(porti, channeli);
+    syncChannelControls(true);
     filterFeedbackSignal = _mm_setzero_ps();
 
-    sawUnison = static_cast<int>(*synth.paramToValue.at(ConduitPolysynth::pmSawUnisonCount));
+    sawUnison = static_cast<int>(synth.partParamValue(part, ConduitPolysynth::pmSawUnisonCount));
 
-    sawActive = static_cast<bool>(*synth.paramToValue.at(ConduitPolysynth::pmSawActive));
-    pulseActive = static_cast<bool>(*synth.paramToValue.at(ConduitPolysynth::pmPWActive));
-    sinActive = static_cast<bool>(*synth.paramToValue.at(ConduitPolysynth::pmSinActive));
-    noiseActive = static_cast<bool>(*synth.paramToValue.at(ConduitPolysynth::pmNoiseActive));
+    sawActive = static_cast<bool>(synth.partParamValue(part, ConduitPolysynth::pmSawActive));
+    pulseActive = static_cast<bool>(synth.partParamValue(part, ConduitPolysynth::pmPWActive));
+    sawUseWavetable = synth.partParamValue(part, ConduitPolysynth::pmSawOscMode) > 0.5;
+    pulseUseWavetable = synth.partParamValue(part, ConduitPolysynth::pmPWOscMode) > 0.5;
+    sinActive = static_cast<bool>(synth.partParamValue(part, ConduitPolysynth::pmSinActive));
+    noiseActive = static_cast<bool>(synth.partParamValue(part, ConduitPolysynth::pmNoiseActive));
 
-    svfActive = static_cast<bool>(*synth.paramToValue.at(ConduitPolysynth::pmSVFActive));
+    svfActive = static_cast<bool>(synth.partParamValue(part, ConduitPolysynth::pmSVFActive));
     if (svfActive)
     {
-        svfMode = static_cast<int>(*synth.paramToValue.at(ConduitPolysynth::pmSVFFilterMode));
+        svfMode = static_cast<int>(synth.partParamValue(part, ConduitPolysynth::pmSVFFilterMode));
         switch (svfMode)
         {
         case StereoSimperSVF::LP:
@@ -390,21 +526,21 @@ void PolysynthVoice::start(int16_t porti, int16_t channeli, int16_t keyi, int32_
         case StereoSimperSVF::ALL:
             svfFilterOp = StereoSimperSVF::stepSSE<StereoSimperSVF::ALL>;
             break;
+        default:
+            svfActive = false;
+            break;
         }
     }
-    else
-    {
-        svfFilterOp = [](auto &a, auto b) { return b; };
-    }
 
     gated = true;
     active = true;
+    stolen = false;
     srInv = 1.0 / samplerate;
 
     svfImpl.init();
 
-    aeg.attackFrom(0.f, aegValues.attack.value(), 0, false);
-    feg.attackFrom(0.f, fegValues.attack.value(), 0, false);
+    ModulatorBank::attack(aeg, aegState);
+    ModulatorBank::attack(feg, fegState);
     if (sawUnison == 1)
     {
         sawUniVoiceDetune[0] = 0;
@@ -427,55 +563,30 @@ void PolysynthVoice::start(int16_t porti, int16_t channeli, int16_t keyi, int32_
 
     for (auto &o : sawOsc)
         o.retrigger();
+    sawWavetable.setUnison(sawUnison, sawUniPanL.data(), sawUniPanR.data(),
+                           sawUniLevelNorm.data());
+    sawWavetable.retrigger();
+    pulseWavetable.retrigger();
 
     recalcPitch();
     recalcFilter();
 
-    wsActive = static_cast<bool>(*synth.paramToValue.at(ConduitPolysynth::pmWSActive));
+    wsActive = static_cast<bool>(synth.partParamValue(part, ConduitPolysynth::pmWSActive));
 
     if (wsActive)
     {
-        float R[sst::waveshapers::n_waveshaper_registers];
-        auto wsTypeEnum =
-            static_cast<Waveshapers>(*synth.paramToValue.at(ConduitPolysynth::pmWSMode));
-
-        auto type = sst::waveshapers::WaveshaperType::wst_ojd;
-        switch (wsTypeEnum)
-        {
-        case Soft:
-            type = sst::waveshapers::WaveshaperType::wst_soft;
-            break;
-        case OJD:
-            type = sst::waveshapers::WaveshaperType::wst_ojd;
-            break;
-        case Digital:
-            type = sst::waveshapers::WaveshaperType::wst_digital;
-            break;
-        case FullWaveRect:
-            type = sst::waveshapers::WaveshaperType::wst_fwrectify;
-            break;
-        case WestcoastFold:
-            type = sst::waveshapers::WaveshaperType::wst_westfold;
-            break;
-        case Fuzz:
-            type = sst::waveshapers::WaveshaperType::wst_fuzz;
-            break;
-        }
-        sst::waveshapers::initializeWaveshaperRegister(type, R);
-
-        for (int i = 0; i < sst::waveshapers::n_waveshaper_registers; ++i)
-        {
-            wsState.R[i] = _mm_set1_ps(R[i]);
-        }
-        wsState.init = _mm_cmpneq_ps(_mm_setzero_ps(), _mm_setzero_ps());
-        wsPtr = sst::waveshapers::GetQuadWaveshaper(type);
-    }
-    else
-    {
-        wsPtr = wsNoOp;
+        auto wsShape = static_cast<int>(synth.partParamValue(part, ConduitPolysynth::pmWSMode));
+        auto type = WaveshaperTables::typeFor(wsShape);
+        WaveshaperTables::initializeState(type, wsState);
+
+        wsPtr = nullptr;
+        if (synth.partParamValue(part, ConduitPolysynth::pmWSTableMode) > 0.5)
+            wsPtr = WaveshaperTables::get().lookupFor(wsShape);
+        if (!wsPtr)
+            wsPtr = sst::waveshapers::GetQuadWaveshaper(type);
     }
 
-    lpfActive = static_cast<bool>(*synth.paramToValue.at(ConduitPolysynth::pmLPFActive));
+    lpfActive = static_cast<bool>(synth.partParamValue(part, ConduitPolysynth::pmLPFActive));
 
     if (lpfActive)
     {
@@ -488,65 +599,55 @@ void PolysynthVoice::start(int16_t porti, int16_t channeli, int16_t keyi, int32_
             qfState.WP[i] = 0;
         }
 
-        auto lpfTypeEnum =
-            static_cast<LPFTypes>(*synth.paramToValue.at(ConduitPolysynth::pmLPFFilterMode));
-
-        switch (lpfTypeEnum)
-        {
-        case OBXD:
-            qfType = sst::filters::FilterType::fut_obxd_4pole;
-            qfSubType = (sst::filters::FilterSubType)3; // 24dv
-            break;
-        case Vintage:
-            qfType = sst::filters::FilterType::fut_vintageladder;
-            qfSubType = (sst::filters::FilterSubType)0;
-            break;
-        case K35:
-            qfType = sst::filters::FilterType::fut_k35_lp;
-            qfSubType = (sst::filters::FilterSubType)2; // medium saturation
-            break;
-        case Comb:
-            qfType = sst::filters::FilterType::fut_comb_pos;
-            qfSubType = (sst::filters::FilterSubType)1;
-            break;
-        case CutWarp:
-            qfType = sst::filters::FilterType::fut_cutoffwarp_lp;
-            qfSubType = sst::filters::FilterSubType::st_cutoffwarp_ojd3;
-            break;
-        case ResWarp:
-            qfType = sst::filters::FilterType::fut_resonancewarp_lp;
-            qfSubType = sst::filters::FilterSubType::st_resonancewarp_tanh4;
-            break;
-        }
+        auto lpfType = static_cast<int>(
+            synth.partParamValue(part, ConduitPolysynth::pmLPFFilterMode));
+        std::tie(qfType, qfSubType) = lpfFilterTypes(lpfType);
 
         qfPtr = sst::filters::GetCompensatedQFPtrFilterUnit<true>(qfType, qfSubType);
     }
-    else
-    {
-        qfPtr = qfNoOp;
-    }
 
     filterRouting =
-        static_cast<FilterRouting>(*synth.paramToValue.at(ConduitPolysynth::pmFilterRouting));
+        static_cast<FilterRouting>(synth.partParamValue(part, ConduitPolysynth::pmFilterRouting));
 
-    anyFilterStepActive = wsActive || svfActive || lpfActive;
+    filterStages = (lpfActive && qfPtr ? stageLPF : 0) | (wsActive && wsPtr ? stageWS : 0) |
+                   (svfActive ? stageSVF : 0);
+    anyFilterStepActive = filterStages != 0;
 
-    auto l1shp = static_cast<int>(*synth.paramToValue.at(ConduitPolysynth::pmLFOShape));
+    auto l1shp = static_cast<int>(synth.partParamValue(part, ConduitPolysynth::pmLFOShape));
     if (l1shp > 1)
         l1shp++;
     lfoData[0].shape = (lfo_t::Shape)l1shp;
     lfos[0].attack(lfoData[0].shape);
 
     auto l2shp = static_cast<int>(
-        *synth.paramToValue.at(ConduitPolysynth::pmLFOShape + ConduitPolysynth::offPmLFO2));
+        synth.partParamValue(part, ConduitPolysynth::pmLFOShape + ConduitPolysynth::offPmLFO2));
     if (l2shp > 1)
         l2shp++;
     lfoData[1].shape = (lfo_t::Shape)l2shp;
     lfos[1].attack(lfoData[1].shape);
 
-    // This obviously can be built at start time more intelligently
+    bindMatrix();
+}
+
+/*
+ * Point the routings at the current matrix snapshot for our part. This runs at start and
+ * again from processBlock whenever a new snapshot has been published, so it must not
+ * allocate; it is a handful of lookups and pointer assignments.
+ */
+void PolysynthVoice::bindMatrix()
+{
+    const auto *snap = synth.parts[part].matrix.load();
+    boundMatrixVersion = snap->version;
+
+    // Targets we are about to stop driving would otherwise hold their last modulation
+    for (auto &r : routings)
+    {
+        if (r.target)
+            *(r.target) = 0;
+    }
+
     int idx{0};
-    for (auto &r : synth.patch.extension.modMatrixConfig->routings)
+    for (auto &r : snap->value.routings)
     {
         if (idx >= routings.size())
         {
@@ -558,8 +659,7 @@ void PolysynthVoice::start(int16_t porti, int16_t channeli, int16_t keyi, int32_
 
         if (r.source != ModMatrixConfig::NONE && r.target != ConduitPolysynth::pmNoModTarget)
         {
-            auto pmd = synth.paramDescriptionMap.at(r.target);
-            rt.range = pmd.maxVal - pmd.minVal;
+            rt.range = snap->value.targetRanges[idx];
             auto tp = internalMods.find(r.target);
 
             auto assignMod = [this](const auto &basedOn, auto &to) {
@@ -586,11 +686,11 @@ void PolysynthVoice::start(int16_t porti, int16_t channeli, int16_t keyi, int32_
                     break;
 
                 case ModMatrixConfig::ChannelAT:
-                    to = &channelPressure;
+                    to = &channelControls->channelPressure;
                     break;
 
                 case ModMatrixConfig::ModWheel:
-                    to = &midi1CC[1];
+                    to = &channelControls->midi1CC[1];
                     break;
 
                 case ModMatrixConfig::ReleaseVelocity:
@@ -620,12 +720,67 @@ void PolysynthVoice::start(int16_t porti, int16_t channeli, int16_t keyi, int32_
     }
 }
 
+/*
+ * Pick up bend, timbre and pressure from the channel. Timbre and pressure can also arrive
+ * per note as expressions, so they only follow the channel when its value has moved since
+ * we last looked, which is what a per voice CC or pressure message used to do.
+ */
+void PolysynthVoice::syncChannelControls(bool fromStart)
+{
+    const auto &cc = *channelControls;
+    channelControlsVersion = cc.version;
+
+    if (mpeGlobalControls)
+    {
+        mpeGlobalControlsVersion = mpeGlobalControls->version;
+        pitchBendWheel = mpeGlobalControls->pitchBend * 2; // just hardcode a bend depth of 2
+        mpePitchBend = cc.pitchBend;
+    }
+    else
+    {
+        pitchBendWheel = cc.pitchBend * 2;
+        mpePitchBend = 0;
+    }
+
+    if (fromStart || cc.midi1CC[74] != lastTimbreCC)
+    {
+        lastTimbreCC = cc.midi1CC[74];
+        mpeTimbre = lastTimbreCC;
+    }
+    if (fromStart || cc.channelPressure != lastChannelPressure)
+    {
+        lastChannelPressure = cc.channelPressure;
+        mpePressure = lastChannelPressure;
+    }
+}
+
 void PolysynthVoice::release() { gated = false; }
 
-void PolysynthVoice::StereoSimperSVF::setCoeff(float key, float res, float srInv)
+std::pair<sst::filters::FilterType, sst::filters::FilterSubType>
+PolysynthVoice::lpfFilterTypes(int lpfType)
 {
-    auto co = 440.0 * pow(2.0, (key - 69.0) / 12);
-    co = std::clamp(co, 10.0, 25000.0); // just to be safe/lazy
+    namespace sf = sst::filters;
+    switch ((LPFTypes)lpfType)
+    {
+    case Vintage:
+        return {sf::FilterType::fut_vintageladder, (sf::FilterSubType)0};
+    case K35:
+        return {sf::FilterType::fut_k35_lp, (sf::FilterSubType)2}; // medium saturation
+    case Comb:
+        return {sf::FilterType::fut_comb_pos, (sf::FilterSubType)1};
+    case CutWarp:
+        return {sf::FilterType::fut_cutoffwarp_lp, sf::FilterSubType::st_cutoffwarp_ojd3};
+    case ResWarp:
+        return {sf::FilterType::fut_resonancewarp_lp, sf::FilterSubType::st_resonancewarp_tanh4};
+    case OBXD:
+    default:
+        return {sf::FilterType::fut_obxd_4pole, (sf::FilterSubType)3}; // 24db
+    }
+}
+
+void PolysynthVoice::StereoSimperSVF::setCoeff(float freq, float res, float srInv)
+{
+    auto co = std::clamp(freq, 10.f, 25000.f); // just to be safe/lazy
     res = std::clamp(res, 0.01f, 0.99f);
     g = _mm_set1_ps(sst::basic_blocks::dsp::fasttan(pival * co * srInv));
     k = _mm_set1_ps(2.0 - 2.0 * res);
@@ -695,6 +850,18 @@ __m128 PolysynthVoice::StereoSimperSVF::stepSSE(StereoSimperSVF &that, __m128 vi
     return res;
 }
 
+// Instantiated here so code outside this file, such as the benchmarks, can use every mode
+#define SVF_INSTANTIATE(M)                                                                         \
+    template __m128 PolysynthVoice::StereoSimperSVF::stepSSE<PolysynthVoice::StereoSimperSVF::M>(  \
+        StereoSimperSVF &, __m128);
+SVF_INSTANTIATE(LP)
+SVF_INSTANTIATE(HP)
+SVF_INSTANTIATE(BP)
+SVF_INSTANTIATE(NOTCH)
+SVF_INSTANTIATE(PEAK)
+SVF_INSTANTIATE(ALL)
+#undef SVF_INSTANTIATE
+
 void PolysynthVoice::StereoSimperSVF::init()
 {
     ic1eq = _mm_setzero_ps();
@@ -705,6 +872,8 @@ void PolysynthVoice::attachTo(sst::conduit::polysynth::ConduitPolysynth &p)
 {
     auto attach = [this, &p](clap_id parm, ModulatedValue &toThat) {
         p.attachParam(parm, toThat.base);
+        toThat.patchIndex = p.paramToPatchIndex.at(parm);
+        patchBoundValues.push_back(&toThat);
         externalMods[parm] = 0;
         internalMods[parm] = 0;
         toThat.internalMod = &(internalMods[parm]);
@@ -772,6 +941,17 @@ void PolysynthVoice::attachTo(sst::conduit::polysynth::ConduitPolysynth &p)
     mtsClient = p.mtsClient;
 }
 
+void PolysynthVoice::bindToPart(int p)
+{
+    part = p;
+    uniforms = &synth.parts[part].uniforms;
+    auto params = synth.parts[part].params;
+    for (auto *mv : patchBoundValues)
+    {
+        mv->base = params + mv->patchIndex;
+    }
+}
+
 void PolysynthVoice::applyExternalMod(clap_id param, float value)
 {
     auto emit = externalMods.find(param);
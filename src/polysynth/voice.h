@@ -26,6 +26,8 @@
 #include <random>
 #include <unordered_map>
 #include <functional>
+#include <utility>
+#include <vector>
 
 #include <clap/clap.h>
 
@@ -37,10 +39,13 @@
 #include "sst/basic-blocks/modulators/ADSREnvelope.h"
 #include "sst/basic-blocks/modulators/SimpleLFO.h"
 #include "sst/basic-blocks/dsp/BlockInterpolators.h"
+#include "sst/basic-blocks/dsp/PanLaws.h"
 
 #include "sst/filters.h"
 #include "sst/waveshapers.h"
 
+#include "saw-wavetable.h"
+
 struct MTSClient;
 
 namespace sst::conduit::polysynth
@@ -48,6 +53,39 @@ namespace sst::conduit::polysynth
 
 struct ConduitPolysynth;
 
+inline float cubed(float x) { return x * x * x; }
+
+/*
+ * Control values which depend only on the patch. The synth computes these once per block
+ * for each part and a voice uses them, rather than redoing the math, whenever that voice
+ * has no modulation on the underlying parameter.
+ */
+struct PatchUniforms
+{
+    float aegPFGLinear{1.f};
+    float wsDriveLinear{1.f};
+
+    float sawLevelCubed{0.f}, pulseLevelCubed{0.f}, sinLevelCubed{0.f}, noiseLevelCubed{0.f};
+    float outputLevelCubed{0.f};
+
+    bool outputPanCentered{true};
+    sst::basic_blocks::dsp::pan_laws::panmatrix_t outputPanMatrix{};
+};
+
+/*
+ * The controller state MIDI 1 sends per channel. The synth keeps one of these for each port
+ * and channel and voices point at theirs, so a CC sweep is a single store rather than a
+ * write into every sounding voice. version moves on every change so voices can refresh
+ * what they derive from it (pitch bend, the MPE timbre and pressure) at block rate.
+ */
+struct ChannelControllers
+{
+    float midi1CC[128]{};       // scaled 0...1
+    float channelPressure{0.f}; // scaled 0...1
+    float pitchBend{0.f};       // scaled -1...1
+    uint32_t version{0};
+};
+
 struct PolysynthVoice
 {
     static constexpr int max_uni{7};
@@ -75,13 +113,22 @@ struct PolysynthVoice
     int channel; // midi channel
     int key;     // The midi key which triggered me
     int note_id; // and the note_id delivered by the host (used for note expressions)
+    int part{0}; // the multi-timbral part whose patch I am playing
+    const PatchUniforms *uniforms{nullptr};
+
+    uint64_t startOrder{0}; // for voice stealing
 
     /* Midi Controller Values */
     float velocity{0.f};
     float releaseVelocity{0.f};
-    float polyphonicAT{0.f};    // scaled 0...1
-    float channelPressure{0.f}; // scaled 0..1
-    float midi1CC[128]{};       // scaled 0...1
+    float polyphonicAT{0.f}; // scaled 0...1
+
+    // Bound at start. In MPE mode the global channel's bend comes from mpeGlobalControls.
+    const ChannelControllers *channelControls{nullptr};
+    const ChannelControllers *mpeGlobalControls{nullptr};
+    uint32_t channelControlsVersion{0}, mpeGlobalControlsVersion{0};
+    float lastTimbreCC{0.f}, lastChannelPressure{0.f};
+    void syncChannelControls(bool fromStart);
 
     MTSClient *mtsClient{nullptr};
     void attachTo(ConduitPolysynth &p);
@@ -91,6 +138,7 @@ struct PolysynthVoice
         float *base{nullptr};
         float *externalMod{nullptr};
         float *internalMod{nullptr};
+        int patchIndex{-1};
 
         inline float value()
         {
@@ -99,6 +147,9 @@ struct PolysynthVoice
             assert(externalMod);
             return *base + *externalMod + *internalMod;
         }
+
+        // If true, value() is just the patch value so the part uniforms apply
+        inline bool isUnmodulated() const { return *externalMod == 0.f && *internalMod == 0.f; }
     };
 
     // If you change this also change the param in polysynth.cpp
@@ -131,8 +182,13 @@ struct PolysynthVoice
         ResWarp,
         Comb
     };
+    // The sst-filters type and subtype behind each LPFTypes entry
+    static std::pair<sst::filters::FilterType, sst::filters::FilterSubType>
+    lpfFilterTypes(int lpfType);
 
     std::unordered_map<clap_id, float> externalMods, internalMods;
+    std::vector<ModulatedValue *> patchBoundValues;
+    void bindToPart(int part);
 
     void applyExternalMod(clap_id param, float value);
 
@@ -146,6 +202,8 @@ struct PolysynthVoice
                    sst::basic_blocks::dsp::BlockInterpSmoothingStrategy<blockSize>>,
                max_uni>
         sawOsc;
+    bool sawUseWavetable{false};
+    WavetableSawUnison sawWavetable;
 
     // Pulse Oscillator
     bool pulseActive{true};
@@ -154,6 +212,8 @@ struct PolysynthVoice
     sst::basic_blocks::dsp::DPWPulseOscillator<
         sst::basic_blocks::dsp::BlockInterpSmoothingStrategy<blockSize>>
         pulseOsc;
+    bool pulseUseWavetable{false};
+    WavetablePulse pulseWavetable;
 
     // Sin Oscillator
     bool sinActive{true};
@@ -169,7 +229,7 @@ struct PolysynthVoice
     std::default_random_engine gen;
     std::uniform_real_distribution<float> urd;
 
-    sst::basic_blocks::dsp::lipol_sse<blockSizeOS, true> aegPFG_lipol;
+    sst::basic_blocks::dsp::lipol<float, blockSizeOS, true> aegPFG_lipol;
     ModulatedValue aegPFG;
 
     bool svfActive;
@@ -201,6 +261,19 @@ struct PolysynthVoice
 
     bool anyFilterStepActive;
 
+    /*
+     * The filter stages this voice runs, worked out at start. Inactive stages are compiled
+     * out of processFrames rather than called as no-ops, so a routing collapses to the
+     * stages actually in use and a parallel pair with one side off is just a dry mix.
+     */
+    enum FilterStages
+    {
+        stageLPF = 1,
+        stageWS = 2,
+        stageSVF = 4
+    };
+    int filterStages{0};
+
     ModulatedValue outputPan, outputLevel;
     sst::basic_blocks::dsp::lipol_sse<blockSizeOS, true> outputLevel_lipol;
 
@@ -218,6 +291,13 @@ struct PolysynthVoice
 
     using env_t = sst::basic_blocks::modulators::ADSREnvelope<PolysynthVoice, blockSizeOS>;
     env_t aeg, feg;
+
+    // What the ModulatorBank carries between blocks for each analog envelope
+    struct AnalogEnvState
+    {
+        float level{0.f}, levelDelayed{0.f};
+        int32_t discharge{0}; // all bits set once the attack has turned to decay
+    } aegState, fegState;
     bool gated{false};
     bool active{false};
 
@@ -229,36 +309,53 @@ struct PolysynthVoice
         ModulatedValue rate, deform, amplitude;
     } lfoData[2];
 
+    // The envelopes and LFOs have already run for this block, in the synth's ModulatorBank
     void processBlock();
 
     float outputOS alignas(16)[2][blockSizeOS];
 
+    /*
+     * Inside processBlock the voice runs on interleaved (L, R, 0, 0) frames, which is the
+     * layout the quad filters and waveshapers consume, and only goes back to the planar
+     * outputOS after the AEG.
+     */
+    __m128 frames[blockSizeOS];
+    static inline __m128 monoFrame(float v) { return _mm_set_ps(0, 0, v, v); }
+
+    struct FrameRamps
+    {
+        __m128 pfg[blockSizeOS], drive[blockSizeOS], bias[blockSizeOS], fback[blockSizeOS];
+    };
+    static constexpr int noFilterRouting{-1};
+    template <int routing, int stages = 0> void processFrames(const FrameRamps &ramps);
+    template <int routing> void dispatchFilterStages(const FrameRamps &ramps);
+
     void start(int16_t port, int16_t channel, int16_t key, int32_t noteid, double velocity);
     void release();
 
+    /*
+     * A stolen voice has already left the voice manager, but rather than cut it we fade it
+     * out over stealFadeSeconds while the new note starts in a spare voice.
+     */
+    static constexpr float stealFadeSeconds{0.003f};
+    bool stolen{false};
+    int stealFadeBlocks{1}, stealFadeRemaining{0};
+    void beginStealFade();
+
     float baseFrequencyByMidiKey[128];
     void recalcPitch();
     void recalcFilter();
 
     void receiveNoteExpression(int expression, double value);
     void applyPolyphonicAftertouch(int8_t val) { polyphonicAT = 1.f * val / 127.f; }
-    void applyChannelPressure(int8_t val)
-    {
-        channelPressure = 1.f * val / 127.f;
-        mpePressure = channelPressure;
-    }
-    void applyMIDI1CC(uint8_t cc, uint8_t val)
-    {
-        assert(cc >= 0);
-        midi1CC[cc] = 1.f * val / 127.f;
-        if (cc == 74)
-            mpeTimbre = midi1CC[cc];
-    }
 
-    // Sigh - fix this to a table of course
-    inline float envelope_rate_linear_nowrap(float f) { return blockSizeOS * srInv * pow(2.f, -f); }
+    // Called by the envelopes and LFOs; reads the synth's shared 2^x table
+    float envelope_rate_linear_nowrap(float f);
 
-    inline bool isPlaying() const { return aeg.stage < env_t::s_eoc; }
+    inline bool isPlaying() const
+    {
+        return aeg.stage < env_t::s_eoc && !(stolen && stealFadeRemaining <= 0);
+    }
 
     struct StereoSimperSVF // thanks to urs @ u-he and andy simper @ cytomic
     {
@@ -277,14 +374,15 @@ struct PolysynthVoice
             ALL
         };
 
-        void setCoeff(float key, float res, float srInv);
+        void setCoeff(float freq, float res, float srInv);
 
         template <int Mode> static void step(StereoSimperSVF &that, float &L, float &R);
         template <int Mode> static __m128 stepSSE(StereoSimperSVF &that, __m128);
 
         void init();
     } svfImpl;
-    std::function<__m128(StereoSimperSVF &, __m128)> svfFilterOp;
+    using svfFilterOp_t = __m128 (*)(StereoSimperSVF &, __m128);
+    svfFilterOp_t svfFilterOp{nullptr};
 
     sst::waveshapers::QuadWaveshaperPtr wsPtr{nullptr};
     sst::waveshapers::QuadWaveshaperState wsState;
@@ -299,14 +397,16 @@ struct PolysynthVoice
 
     struct ModRoutingData
     {
-        float *source{nullptr};
-        float *via{nullptr};
+        const float *source{nullptr};
+        const float *via{nullptr};
         float *target{nullptr};
-        float *depth{nullptr};
+        const float *depth{nullptr};
         float range;
     };
 
     std::array<ModRoutingData, 8> routings;
+    uint64_t boundMatrixVersion{0};
+    void bindMatrix();
 
   private:
     double baseFreq{440.0};
@@ -0,0 +1,179 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#include "waveshaper-tables.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "voice.h"
+
+namespace sst::conduit::polysynth
+{
+namespace sws = sst::waveshapers;
+
+static const WaveshaperTables *theTables{nullptr};
+
+/*
+ * SSE2 has no gather, so we emulate one: compute the four indices in register, spill
+ * them and load the bracketing table points. Only two lanes carry audio in the voice but
+ * the cost of the other two is in the noise next to the kernels this replaces.
+ */
+template <int shape>
+static __m128 lookupWaveshaper(sws::QuadWaveshaperState *__restrict, __m128 in, __m128 drive)
+{
+    static constexpr float scale{WaveshaperTables::tableSize / (2 * WaveshaperTables::inputRange)};
+    static constexpr float xMax{WaveshaperTables::tableSize - 1.f / 1024};
+
+    const auto &t = theTables->tables[shape].values;
+
+    auto u = _mm_mul_ps(in, drive);
+    auto x = _mm_mul_ps(_mm_add_ps(u, _mm_set1_ps(WaveshaperTables::inputRange)),
+                        _mm_set1_ps(scale));
+    x = _mm_min_ps(_mm_max_ps(x, _mm_setzero_ps()), _mm_set1_ps(xMax));
+
+    auto xi = _mm_cvttps_epi32(x);
+    auto frac = _mm_sub_ps(x, _mm_cvtepi32_ps(xi));
+
+    int idx alignas(16)[4];
+    _mm_store_si128((__m128i *)idx, xi);
+
+    auto lo = _mm_set_ps(t[idx[3]], t[idx[2]], t[idx[1]], t[idx[0]]);
+    auto hi = _mm_set_ps(t[idx[3] + 1], t[idx[2] + 1], t[idx[1] + 1], t[idx[0] + 1]);
+
+    return _mm_add_ps(lo, _mm_mul_ps(frac, _mm_sub_ps(hi, lo)));
+}
+
+static constexpr sws::QuadWaveshaperPtr lookupKernels[WaveshaperTables::nShapes]{
+    lookupWaveshaper<0>, lookupWaveshaper<1>, lookupWaveshaper<2>,
+    lookupWaveshaper<3>, lookupWaveshaper<4>, lookupWaveshaper<5>};
+
+const WaveshaperTables &WaveshaperTables::get()
+{
+    static WaveshaperTables instance;
+    return instance;
+}
+
+WaveshaperTables::WaveshaperTables()
+{
+    theTables = this;
+    for (int i = 0; i < nShapes; ++i)
+    {
+        build(i);
+        measure(i);
+    }
+}
+
+sws::WaveshaperType WaveshaperTables::typeFor(int shape)
+{
+    switch ((PolysynthVoice::Waveshapers)shape)
+    {
+    case PolysynthVoice::Soft:
+        return sws::WaveshaperType::wst_soft;
+    case PolysynthVoice::OJD:
+        return sws::WaveshaperType::wst_ojd;
+    case PolysynthVoice::Digital:
+        return sws::WaveshaperType::wst_digital;
+    case PolysynthVoice::FullWaveRect:
+        return sws::WaveshaperType::wst_fwrectify;
+    case PolysynthVoice::WestcoastFold:
+        return sws::WaveshaperType::wst_westfold;
+    case PolysynthVoice::Fuzz:
+        return sws::WaveshaperType::wst_fuzz;
+    }
+    return sws::WaveshaperType::wst_ojd;
+}
+
+void WaveshaperTables::initializeState(sws::WaveshaperType type, sws::QuadWaveshaperState &state)
+{
+    float R[sws::n_waveshaper_registers];
+    sws::initializeWaveshaperRegister(type, R);
+
+    for (int i = 0; i < sws::n_waveshaper_registers; ++i)
+    {
+        state.R[i] = _mm_set1_ps(R[i]);
+    }
+    state.init = _mm_cmpneq_ps(_mm_setzero_ps(), _mm_setzero_ps());
+}
+
+void WaveshaperTables::build(int shape)
+{
+    auto type = typeFor(shape);
+    auto kernel = sws::GetQuadWaveshaper(type);
+    auto &tb = tables[shape];
+
+    for (int i = 0; i <= tableSize; ++i)
+    {
+        auto u = -inputRange + i * (2 * inputRange / tableSize);
+
+        // Run each point twice from a fresh state so stateful kernels settle on f(u)
+        sws::QuadWaveshaperState st;
+        initializeState(type, st);
+        kernel(&st, _mm_set1_ps(u), _mm_set1_ps(1.f));
+        auto res = kernel(&st, _mm_set1_ps(u), _mm_set1_ps(1.f));
+        tb.values[i] = _mm_cvtss_f32(res);
+    }
+}
+
+/*
+ * The test signal is a biased 220hz sine at the voice's oversampled rate, with an
+ * amplitude a bit above what a full level oscillator mix produces, swept across the
+ * drive parameter range of +/- 24db.
+ */
+void WaveshaperTables::measure(int shape)
+{
+    static constexpr int nSamples{4096};
+    static constexpr float testRate{88200.f}, testFreq{220.f}, amplitude{1.5f}, bias{0.2f};
+
+    auto type = typeFor(shape);
+    auto kernel = sws::GetQuadWaveshaper(type);
+    auto &tb = tables[shape];
+
+    float maxErr{0.f};
+    for (int db = -24; db <= 24; db += 6)
+    {
+        auto drive = _mm_set1_ps(std::pow(10.f, db / 20.f));
+
+        sws::QuadWaveshaperState st;
+        initializeState(type, st);
+
+        for (int s = 0; s < nSamples; ++s)
+        {
+            auto x = bias + amplitude * std::sin(2.0 * M_PI * testFreq * s / testRate);
+            auto in = _mm_set1_ps((float)x);
+            auto ref = _mm_cvtss_f32(kernel(&st, in, drive));
+            auto lut = _mm_cvtss_f32(lookupKernels[shape](&st, in, drive));
+            if (std::isfinite(ref))
+                maxErr = std::max(maxErr, std::fabs(ref - lut));
+        }
+    }
+
+    tb.measuredError = maxErr;
+    tb.usable = maxErr <= maxAllowedError;
+}
+
+sws::QuadWaveshaperPtr WaveshaperTables::lookupFor(int shape) const
+{
+    if (shape < 0 || shape >= nShapes || !tables[shape].usable)
+        return nullptr;
+    return lookupKernels[shape];
+}
+} // namespace sst::conduit::polysynth
@@ -0,0 +1,77 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_SRC_POLYSYNTH_WAVESHAPER_TABLES_H
+#define CONDUIT_SRC_POLYSYNTH_WAVESHAPER_TABLES_H
+
+#include <array>
+
+#include "conduit-shared/sse-include.h"
+#include "sst/waveshapers.h"
+
+namespace sst::conduit::polysynth
+{
+/*
+ * Interpolated lookup tables standing in for the voice waveshaper kernels. Each shape is
+ * tabulated as f(u) with u = input * drive, which is how the sst quad waveshapers apply
+ * drive, over +/- inputRange and then read with linear interpolation.
+ *
+ * Not every kernel is a memoryless function of input * drive (the anti-aliased ones carry
+ * state), so after building a table we run a test signal through both the table and the
+ * reference kernel across the drive range and record the max error. A table is only
+ * handed out if that measured error is within maxAllowedError; otherwise the voice keeps
+ * the exact kernel.
+ *
+ * The tables are built once on the first call to get(), which the synth makes from its
+ * constructor on the main thread.
+ */
+struct WaveshaperTables
+{
+    static constexpr int nShapes{6}; // the PolysynthVoice::Waveshapers enum
+    static constexpr int tableSize{8192};
+    static constexpr float inputRange{64.f};
+    static constexpr float maxAllowedError{1e-3f};
+
+    struct Table
+    {
+        float values[tableSize + 1]; // u = -inputRange ... inputRange inclusive
+        float measuredError{0.f};
+        bool usable{false};
+    };
+    std::array<Table, nShapes> tables;
+
+    static const WaveshaperTables &get();
+
+    static sst::waveshapers::WaveshaperType typeFor(int shape);
+    static void initializeState(sst::waveshapers::WaveshaperType type,
+                                sst::waveshapers::QuadWaveshaperState &state);
+
+    // The table kernel for a shape, or nullptr if its table failed the error bound
+    sst::waveshapers::QuadWaveshaperPtr lookupFor(int shape) const;
+
+  private:
+    WaveshaperTables();
+    void build(int shape);
+    void measure(int shape);
+};
+} // namespace sst::conduit::polysynth
+
+#endif // CONDUIT_SRC_POLYSYNTH_WAVESHAPER_TABLES_H
@@ -23,6 +23,7 @@
 #include "juce_gui_basics/juce_gui_basics.h"
 #include "sst/basic-blocks/mechanics/block-ops.h"
 #include "version.h"
+#include "conduit-shared/audio-port-io.h"
 
 namespace sst::conduit::ring_modulator
 {
@@ -99,6 +100,7 @@ ConduitRingModulator::ConduitRingModulator(const clap_host *host)
 
     attachParam(pmAlgo, algo);
     attachParam(pmSource, src);
+    attachDerived(internalRateInputs, {pmInternalSourceFrequency});
 
     clapJuceShim = std::make_unique<sst::clap_juce_shim::ClapJuceShim>(this);
     clapJuceShim->setResizable(true);
@@ -109,24 +111,24 @@ ConduitRingModulator::~ConduitRingModulator() {}
 bool ConduitRingModulator::audioPortsInfo(uint32_t index, bool isInput,
                                           clap_audio_port_info *info) const noexcept
 {
-    static constexpr uint32_t inId{16}, outId{72};
+    static constexpr uint32_t inId{16}, scId{17}, outId{72};
     if (isInput)
     {
         if (index == 0)
         {
             info->id = inId;
-            info->in_place_pair = CLAP_INVALID_ID;
+            info->in_place_pair = outId;
             strncpy(info->name, "main input", sizeof(info->name));
-            info->flags = CLAP_AUDIO_PORT_IS_MAIN;
+            info->flags = CLAP_AUDIO_PORT_IS_MAIN | CLAP_AUDIO_PORT_SUPPORTS_64BITS;
             info->channel_count = 2;
             info->port_type = CLAP_PORT_STEREO;
         }
         else
         {
-            info->id = inId;
+            info->id = scId;
             info->in_place_pair = CLAP_INVALID_ID;
             strncpy(info->name, "ring sidechain", sizeof(info->name));
-            info->flags = 0;
+            info->flags = CLAP_AUDIO_PORT_SUPPORTS_64BITS;
             info->channel_count = 2;
             info->port_type = CLAP_PORT_STEREO;
         }
@@ -135,9 +137,9 @@ bool ConduitRingModulator::audioPortsInfo(uint32_t index, bool isInput,
     else
     {
         info->id = outId;
-        info->in_place_pair = CLAP_INVALID_ID;
+        info->in_place_pair = inId;
         strncpy(info->name, "main output", sizeof(info->name));
-        info->flags = CLAP_AUDIO_PORT_IS_MAIN;
+        info->flags = CLAP_AUDIO_PORT_IS_MAIN | CLAP_AUDIO_PORT_SUPPORTS_64BITS;
         info->channel_count = 2;
         info->port_type = CLAP_PORT_STEREO;
 
@@ -174,13 +176,15 @@ clap_process_status ConduitRingModulator::process(const clap_process *process) n
     if (process->audio_inputs_count <= 0)
         return CLAP_PROCESS_SLEEP;
 
-    float **out = process->audio_outputs[0].data32;
+    // Any of the ports may arrive as 32 or 64 bit; loadSpan and storeSpan convert as we
+    // copy to and from the block buffers
+    const auto &out = process->audio_outputs[0];
     auto ochans = process->audio_outputs->channel_count;
 
-    float **const in = process->audio_inputs[0].data32;
+    const auto &in = process->audio_inputs[0];
     auto ichans = process->audio_inputs->channel_count;
 
-    float **const sidechain = process->audio_inputs[1].data32;
+    const auto &sidechain = process->audio_inputs[1];
     auto scchans = process->audio_inputs->channel_count;
 
     assert(ochans == 2 || ichans == 2 || scchans == 2);
@@ -199,10 +203,11 @@ clap_process_status ConduitRingModulator::process(const clap_process *process) n
     {
         nextEvent = ev->get(ev, nextEventIndex);
     }
+    scanParamRamps(ev);
 
     auto isDigital = *algo < 0.5;
 
-    for (auto i = 0U; i < process->frames_count; ++i)
+    for (auto i = 0U; i < process->frames_count;)
     {
         while (nextEvent && nextEvent->time == i)
         {
@@ -214,78 +219,143 @@ clap_process_status ConduitRingModulator::process(const clap_process *process) n
                 nextEvent = ev->get(ev, nextEventIndex);
         }
 
-        inputBuf[0][pos] = in[0][i];
-        inputBuf[1][pos] = in[1][i];
-        sidechainBuf[0][pos] = sidechain[0][i];
-        sidechainBuf[1][pos] = sidechain[1][i];
+        // Each span runs to the next event or the end of the block being gathered
+        auto spanEnd = std::min(process->frames_count, i + blockSize - pos);
+        if (nextEvent && nextEvent->time > i && nextEvent->time < spanEnd)
+            spanEnd = nextEvent->time;
+        auto n = spanEnd - i;
 
-        out[0][i] = outBuf[0][pos] * mix.v + inMixBuf[0][pos] * (1 - mix.v);
-        out[1][i] = outBuf[1][pos] * mix.v + inMixBuf[1][pos] * (1 - mix.v);
+        // The main input may share its buffer with the output, so the span is latched into
+        // the block buffers before any of its output is written
+        for (int c = 0; c < 2; ++c)
+        {
+            shared::loadSpan(in, c, i, inputBuf[c] + pos, n);
+            shared::loadSpan(sidechain, c, i, sidechainBuf[c] + pos, n);
+        }
+
+        float spanOut alignas(16)[2][blockSize];
+        for (auto k = 0U; k < n; ++k)
+        {
+            spanOut[0][k] = outBuf[0][pos + k] * mix.v + inMixBuf[0][pos + k] * (1 - mix.v);
+            spanOut[1][k] = outBuf[1][pos + k] * mix.v + inMixBuf[1][pos + k] * (1 - mix.v);
+            processLags();
+        }
+        shared::storeSpan(out, 0, i, spanOut[0], n);
+        shared::storeSpan(out, 1, i, spanOut[1], n);
 
-        pos++;
+        pos += n;
+        i = spanEnd;
 
         if (pos == blockSize)
         {
-            memcpy(inMixBuf, inputBuf, sizeof(inMixBuf));
-            hr_up.process_block_U2(inputBuf[0], inputBuf[1], inputOS[0], inputOS[1], blockSizeOS);
+            applyParamRamps(i, i + blockSize);
 
-            if ((Source)(*src) == srcInternal)
+            auto internal = (Source)(*src) == srcInternal;
+            if (internal)
             {
-                static constexpr double mf0{8.17579891564};
-                internalSource.setRate(2.0 * M_PI * note_to_pitch_ignoring_tuning(freq.v + 69) *
-                                       mf0 * dsamplerate_inv * 0.5); // 0.5 for oversample
-
-                for (int i = 0; i < blockSizeOS; ++i)
+                if (internalRateInputs.changed())
+                    internalRateSettling = true;
+                if (internalRateSettling)
                 {
-                    internalSource.step();
-                    sourceOS[0][i] = 2 * internalSource.u;
-                    sourceOS[1][i] = 2 * internalSource.u;
-                }
-            }
-            else
-            {
-                hr_scup.process_block_U2(sidechainBuf[0], sidechainBuf[1], sourceOS[0], sourceOS[1],
-                                         blockSizeOS);
-                mech::scale_by<blockSizeOS>(4, sourceOS[0], sourceOS[1]);
-            }
+                    internalRateSettling = (freq.v != internalRateFreq);
+                    internalRateFreq = freq.v;
 
-            if (isDigital)
-            {
-                mech::mul_block<blockSizeOS>(inputOS[0], sourceOS[0]);
-                mech::mul_block<blockSizeOS>(inputOS[1], sourceOS[1]);
-            }
-            else
-            {
-                for (int c = 0; c < 2; ++c)
-                {
-                    for (int s = 0; s < blockSizeOS; ++s)
-                    {
-                        auto vin = inputOS[c][s];
-                        auto vc = sourceOS[c][s];
-                        auto A = 0.5 * vin + vc;
-                        auto B = vc - 0.5 * vin;
-
-                        auto dPA = diode_sim(A);
-                        auto dMA = diode_sim(-A);
-                        auto dPB = diode_sim(B);
-                        auto dMB = diode_sim(-B);
-
-                        auto res = dPA + dMA - dPB - dMB;
-
-                        inputOS[c][s] = res;
-                    }
+                    internalSource.setRate(2.0 * M_PI * noteToFrequency(freq.v + 69) *
+                                           dsamplerate_inv * 0.5); // 0.5 for oversample
                 }
             }
 
-            hr_down.process_block_D2(inputOS[0], inputOS[1], blockSizeOS, outBuf[0], outBuf[1]);
+            processGatheredBlock(isDigital, internal);
             pos = 0;
         }
-
-        processLags();
     }
     return CLAP_PROCESS_CONTINUE;
 }
 
+// Ring modulates the block gathered in inputBuf and sidechainBuf into outBuf
+void ConduitRingModulator::processGatheredBlock(bool isDigital, bool internal)
+{
+    memcpy(inMixBuf, inputBuf, sizeof(inMixBuf));
+    hr_up.process_block_U2(inputBuf[0], inputBuf[1], inputOS[0], inputOS[1], blockSizeOS);
+
+    if (internal)
+    {
+        for (int i = 0; i < blockSizeOS; ++i)
+        {
+            internalSource.step();
+            sourceOS[0][i] = 2 * internalSource.u;
+            sourceOS[1][i] = 2 * internalSource.u;
+        }
+    }
+    else
+    {
+        hr_scup.process_block_U2(sidechainBuf[0], sidechainBuf[1], sourceOS[0], sourceOS[1],
+                                 blockSizeOS);
+        mech::scale_by<blockSizeOS>(4, sourceOS[0], sourceOS[1]);
+    }
+
+    if (isDigital)
+    {
+        mech::mul_block<blockSizeOS>(inputOS[0], sourceOS[0]);
+        mech::mul_block<blockSizeOS>(inputOS[1], sourceOS[1]);
+    }
+    else
+    {
+        for (int c = 0; c < 2; ++c)
+        {
+            for (int s = 0; s < blockSizeOS; ++s)
+            {
+                auto vin = inputOS[c][s];
+                auto vc = sourceOS[c][s];
+                auto A = 0.5 * vin + vc;
+                auto B = vc - 0.5 * vin;
+
+                auto dPA = diode_sim(A);
+                auto dMA = diode_sim(-A);
+                auto dPB = diode_sim(B);
+                auto dMB = diode_sim(-B);
+
+                auto res = dPA + dMA - dPB - dMB;
+
+                inputOS[c][s] = res;
+            }
+        }
+    }
+
+    hr_down.process_block_D2(inputOS[0], inputOS[1], blockSizeOS, outBuf[0], outBuf[1]);
+}
+
+/*
+ * Both algorithms from both sources over a silent block, so the half rate filters, the
+ * diode and the oscillator are warm for the first process. Everything they move, the
+ * filter histories, the oscillator and the block buffers, is put back after.
+ */
+void ConduitRingModulator::primeKernels()
+{
+    auto up = hr_up, scup = hr_scup, down = hr_down;
+    auto osc = internalSource;
+    float saved alignas(16)[4][2][blockSize];
+    memcpy(saved[0], inputBuf, sizeof(inputBuf));
+    memcpy(saved[1], sidechainBuf, sizeof(sidechainBuf));
+    memcpy(saved[2], outBuf, sizeof(outBuf));
+    memcpy(saved[3], inMixBuf, sizeof(inMixBuf));
+
+    memset(inputBuf, 0, sizeof(inputBuf));
+    memset(sidechainBuf, 0, sizeof(sidechainBuf));
+    for (auto isDigital : {true, false})
+        for (auto internal : {true, false})
+            processGatheredBlock(isDigital, internal);
+
+    memcpy(inputBuf, saved[0], sizeof(inputBuf));
+    memcpy(sidechainBuf, saved[1], sizeof(sidechainBuf));
+    memcpy(outBuf, saved[2], sizeof(outBuf));
+    memcpy(inMixBuf, saved[3], sizeof(inMixBuf));
+    hr_up = up;
+    hr_scup = scup;
+    hr_down = down;
+    internalSource = osc;
+}
+
 void ConduitRingModulator::handleInboundEvent(const clap_event_header_t *evt)
 {
     if (handleParamBaseEvents(evt))
@@ -45,6 +45,7 @@ struct ConduitRingModulatorConfig
     static constexpr int nParams{sst::conduit::ring_modulator::nParams};
     static constexpr bool baseClassProvidesMonoModSupport{true};
     static constexpr bool usesSpecializedMessages{false};
+    static constexpr bool primeOnActivate{true};
     using PatchExtension = sst::conduit::shared::EmptyPatchExtension;
     struct DataCopyForUI
     {
@@ -65,6 +66,8 @@ struct ConduitRingModulator
                   uint32_t maxFrameCount) noexcept override
     {
         setSampleRate(sampleRate);
+        internalRateInputs.invalidate();
+        warmUp();
         return true;
     }
 
@@ -105,6 +108,7 @@ struct ConduitRingModulator
 
     clap_process_status process(const clap_process *process) noexcept override;
     void handleInboundEvent(const clap_event_header_t *evt);
+    void primeKernels();
 
     bool startProcessing() noexcept override
     {
@@ -142,11 +146,20 @@ struct ConduitRingModulator
     float inMixBuf[2][blockSize]{};
 
     uint32_t pos{0};
+    void processGatheredBlock(bool isDigital, bool internal);
 
     lag_t mix, freq;
 
     float *algo, *src;
+
+    // freq is lagged, so after a change we follow it until the lag comes to rest
+    sst::conduit::shared::DerivedValue<1> internalRateInputs;
+    bool internalRateSettling{false};
+    float internalRateFreq{0.f};
 };
+
+// The analog mode's diode transfer curve, applied per oversampled sample
+float diode_sim(float v);
 } // namespace sst::conduit::ring_modulator
 
 #endif // CONDUIT_POLYMETRIC_DELAY_H